@@ -0,0 +1,171 @@
+/*
+ * BenchmarkHarness.cpp
+ *
+ *  Repeated timing of a kernel with warm up runs, optional cache flushing and summary statistics.
+ */
+
+#include "BenchmarkHarness.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <tbb/tick_count.h>
+
+// larger than last level cache of current desktop and server processors
+#define CACHE_FLUSH_BYTES		(64 * 1024 * 1024)
+#define CACHE_LINE_BYTES		64
+
+namespace {
+
+const char* const derivedNames[] = { "ipc", "instructions_per_pixel", "llc_bytes_per_pixel" };
+
+}
+
+void flushDataCache()
+{
+	static std::vector<unsigned char> buffer(CACHE_FLUSH_BYTES);
+	static volatile unsigned char sink;
+	unsigned char sum = 0;
+	for (size_t k = 0; k < buffer.size(); k += CACHE_LINE_BYTES) {
+		buffer[k] = (unsigned char)(buffer[k] + 1);
+		sum += buffer[k];
+	}
+	sink = (unsigned char)(sink + sum);
+}
+
+BenchmarkStats benchmarkStats(std::vector<double> seconds)
+{
+	BenchmarkStats stats = BenchmarkStats();
+	stats.counters = emptyPerfCounts();
+	stats.instructionsPerCycle = stats.instructionsPerPixel = stats.llcBytesPerPixel = -1;
+	stats.repetitions = (int)seconds.size();
+	if (seconds.empty())
+		return stats;
+
+	std::sort(seconds.begin(), seconds.end());
+	size_t n = seconds.size();
+	stats.min = seconds[0];
+	stats.median = n % 2 ? seconds[n / 2] : (seconds[n / 2 - 1] + seconds[n / 2]) / 2;
+	stats.p95 = seconds[std::min(n - 1, (size_t)ceil(0.95 * n) - 1)];
+
+	double sum = 0;
+	for (size_t k = 0; k < n; ++k)
+		sum += seconds[k];
+	stats.mean = sum / n;
+	double squares = 0;
+	for (size_t k = 0; k < n; ++k)
+		squares += (seconds[k] - stats.mean) * (seconds[k] - stats.mean);
+	stats.stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+	return stats;
+}
+
+BenchmarkStats runBenchmark(const std::string& name, int width, int height, double bytes, const BenchmarkOptions& options,
+	const std::function<void()>& kernel)
+{
+	// threads created by the first run (thread pool workers) would not be counted, so counting needs a warm up run
+	int warmup = options.countEvents ? std::max(options.warmup, 1) : options.warmup;
+	for (int k = 0; k < warmup; ++k)
+		kernel();
+
+	std::vector<double> seconds;
+	PerfCounters counters;
+	PerfCounts counts = emptyPerfCounts();
+	int counted = 0;
+	for (int k = 0; k < std::max(options.repetitions, 1); ++k) {
+		if (options.flushCache)
+			flushDataCache();
+		bool counting = options.countEvents && counters.start();
+		auto start = tbb::tick_count::now();
+		kernel();
+		seconds.push_back((tbb::tick_count::now() - start).seconds());
+		if (counting) {
+			addPerfCounts(counts, counters.stop());
+			++counted;
+		}
+	}
+
+	BenchmarkStats stats = benchmarkStats(seconds);
+	for (int e = 0; e < PERF_EVENT_COUNT && counted > 0; ++e)
+		if (counts.counts[e] >= 0)
+			counts.counts[e] /= counted;
+	stats.counters = counts;
+	double pixels = (double)width * height;
+	stats.instructionsPerCycle = perfRatio(counts, PERF_INSTRUCTIONS, PERF_CYCLES);
+	stats.instructionsPerPixel = counts.counts[PERF_INSTRUCTIONS] >= 0 ? counts.counts[PERF_INSTRUCTIONS] / pixels : -1;
+	stats.llcBytesPerPixel = counts.counts[PERF_LLC_MISSES] >= 0 ? counts.counts[PERF_LLC_MISSES] * CACHE_LINE_BYTES / pixels : -1;
+	stats.name = name;
+	stats.width = width;
+	stats.height = height;
+	stats.flushCache = options.flushCache;
+	if (stats.median > 0) {
+		stats.megapixelsPerSecond = (double)width * height / stats.median / 1e6;
+		stats.gigabytesPerSecond = bytes / stats.median / 1e9;
+		stats.nanosecondsPerPixel = stats.median * 1e9 / ((double)width * height);
+	}
+	return stats;
+}
+
+bool isJsonFileName(const char* filename)
+{
+	size_t length = strlen(filename);
+	return length >= 5 && strcmp(filename + length - 5, ".json") == 0;
+}
+
+bool saveBenchmarkResults(const char* filename, const std::vector<BenchmarkStats>& results)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	bool json = isJsonFileName(filename);
+	if (json)
+		fprintf(file, "[\n");
+	else {
+		fprintf(file, "name,width,height,repetitions,cold,min,median,p95,mean,stddev,megapixels_per_second,gigabytes_per_second,ns_per_pixel");
+		for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+			fprintf(file, ",%s", perfEventName((PerfEvent)e));
+		for (int e = 0; e < 3; ++e)
+			fprintf(file, ",%s", derivedNames[e]);
+		fprintf(file, "\n");
+	}
+
+	for (size_t k = 0; k < results.size(); ++k) {
+		const BenchmarkStats& r = results[k];
+		if (json)
+			fprintf(file, "  {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"repetitions\": %d, \"cold\": %s, \"min\": %.9g, "
+				"\"median\": %.9g, \"p95\": %.9g, \"mean\": %.9g, \"stddev\": %.9g, \"megapixels_per_second\": %.6g, "
+				"\"gigabytes_per_second\": %.6g, \"ns_per_pixel\": %.6g", r.name.c_str(), r.width, r.height, r.repetitions,
+				r.flushCache ? "true" : "false", r.min, r.median, r.p95, r.mean, r.stddev, r.megapixelsPerSecond, r.gigabytesPerSecond,
+				r.nanosecondsPerPixel);
+		else
+			fprintf(file, "%s,%d,%d,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.6g,%.6g,%.6g", r.name.c_str(), r.width, r.height, r.repetitions,
+				r.flushCache ? 1 : 0, r.min, r.median, r.p95, r.mean, r.stddev, r.megapixelsPerSecond, r.gigabytesPerSecond,
+				r.nanosecondsPerPixel);
+
+		double values[PERF_EVENT_COUNT + 3];
+		for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+			values[e] = r.counters.counts[e];
+		values[PERF_EVENT_COUNT] = r.instructionsPerCycle;
+		values[PERF_EVENT_COUNT + 1] = r.instructionsPerPixel;
+		values[PERF_EVENT_COUNT + 2] = r.llcBytesPerPixel;
+		for (int e = 0; e < PERF_EVENT_COUNT + 3; ++e) {
+			const char* name = e < PERF_EVENT_COUNT ? perfEventName((PerfEvent)e) : derivedNames[e - PERF_EVENT_COUNT];
+			if (json && values[e] >= 0)
+				fprintf(file, ", \"%s\": %.9g", name, values[e]);
+			else if (json)
+				fprintf(file, ", \"%s\": null", name);
+			else if (values[e] >= 0)
+				fprintf(file, ",%.9g", values[e]);
+			else
+				fprintf(file, ",");
+		}
+		if (json)
+			fprintf(file, "}%s\n", k + 1 < results.size() ? "," : "");
+		else
+			fprintf(file, "\n");
+	}
+
+	if (json)
+		fprintf(file, "]\n");
+	return fclose(file) == 0;
+}
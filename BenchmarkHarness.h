@@ -0,0 +1,87 @@
+/*
+ * BenchmarkHarness.h
+ *
+ *  Repeated timing of a kernel with warm up runs, optional cache flushing and summary statistics.
+ */
+
+#ifndef BENCHMARKHARNESS_H_
+#define BENCHMARKHARNESS_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "PerfCounters.h"
+
+/**
+* @brief How a kernel is timed
+*/
+struct BenchmarkOptions {
+	int warmup;			// untimed runs before the first timed run, at least one when events are counted
+	int repetitions;	// timed runs
+	bool flushCache;	// evict caches before every timed run (cold), otherwise data stays cached from the previous run (warm)
+	bool countEvents;	// read performance counters of all threads around every timed run
+};
+
+/**
+* @brief Statistics of timed runs in seconds, throughput and time per pixel are computed from the median
+*/
+struct BenchmarkStats {
+	std::string name;
+	int width;
+	int height;
+	int repetitions;
+	bool flushCache;
+	double min;
+	double median;
+	double p95;
+	double mean;
+	double stddev;
+	double megapixelsPerSecond;
+	double gigabytesPerSecond;
+	double nanosecondsPerPixel;
+	PerfCounts counters;	// average of timed runs, unavailable if not counted
+	double instructionsPerCycle;	// counter based metrics, negative if not counted
+	double instructionsPerPixel;
+	double llcBytesPerPixel;		// last level cache misses times cache line size
+};
+
+/**
+* @brief Evicts data caches by writing and reading a buffer much larger than the last level cache
+*/
+void flushDataCache();
+
+/**
+* @brief Runs kernel options.warmup times untimed and options.repetitions times timed. Only kernel calls are timed,
+* cache flushing and starting and reading of performance counters happen between timed regions.
+* @param name name of the kernel, copied to the statistics
+* @param width image width
+* @param height image height
+* @param bytes bytes read and written by one kernel run, used for GB/s
+* @param options warm up, repetitions and cache flushing
+* @param kernel function processing the whole image
+*/
+BenchmarkStats runBenchmark(const std::string& name, int width, int height, double bytes, const BenchmarkOptions& options,
+	const std::function<void()>& kernel);
+
+/**
+* @brief Computes statistics of measured times, p95 is the nearest rank percentile
+* @param seconds times of all runs, at least one
+*/
+BenchmarkStats benchmarkStats(std::vector<double> seconds);
+
+/**
+* @brief Are results written as JSON, true if file name ends with .json
+*/
+bool isJsonFileName(const char* filename);
+
+/**
+* @brief Writes statistics as CSV with a header line, or as JSON array of objects if file name ends with .json.
+* Counted events are followed by instructions per cycle, instructions per pixel and last level cache miss bytes
+* per pixel, unavailable values are empty in CSV and null in JSON.
+* @param filename output file name
+* @param results statistics of all benchmarked kernels
+* @return false if file can not be written
+*/
+bool saveBenchmarkResults(const char* filename, const std::vector<BenchmarkStats>& results);
+
+#endif /* BENCHMARKHARNESS_H_ */
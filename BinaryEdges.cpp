@@ -0,0 +1,254 @@
+/*
+ * BinaryEdges.cpp
+ *
+ *  Edge detection on thresholded image packed into 64 bit words.
+ */
+
+#include "BinaryEdges.h"
+#include <stdio.h>
+#include <algorithm>
+
+namespace {
+
+template<typename InPixel>
+void packRow(const InPixel* inRow, uint64_t* packed, int width)
+{
+	for (int w = 0; w * 64 < width; ++w) {
+		const InPixel* in = inRow + w * 64;
+		int count = std::min(64, width - w * 64);
+		uint64_t word = 0;
+		for (int b = 0; b < count; ++b)
+			word |= (uint64_t)(in[b] >= 128) << b;
+		packed[w] = word;
+	}
+}
+
+// bits of row moved shift positions towards bit 0, word w of the result
+inline uint64_t shiftedWord(const uint64_t* row, int words, int w, int shift)
+{
+	int q = w + (shift >> 6), r = shift & 63;
+	uint64_t low = q < words ? row[q] >> r : 0;
+	uint64_t high = r != 0 && q + 1 < words ? row[q + 1] << (64 - r) : 0;
+	return low | high;
+}
+
+struct OrOp {
+	uint64_t operator()(uint64_t a, uint64_t b) const { return a | b; }
+};
+
+struct AndOp {
+	uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; }
+};
+
+/**
+* @brief Bit x of result is op over bits x .. x + window - 1 of row. Windows of doubling span are built
+* in place, window is then covered by two windows of the largest span not bigger than window.
+*/
+template<typename Op>
+void windowReduce(const uint64_t* row, uint64_t* result, int words, int window, Op op)
+{
+	std::copy(row, row + words, result);
+	int span = 1;
+	for (; span * 2 <= window; span *= 2)
+		for (int w = 0; w < words; ++w)
+			result[w] = op(result[w], shiftedWord(result, words, w, span));
+	if (span < window)
+		for (int w = 0; w < words; ++w)
+			result[w] = op(result[w], shiftedWord(result, words, w, window - span));
+}
+
+template<typename OutPixel>
+struct PixelSink {
+	OutPixel* outBuffer;
+	int width;
+	int offset;
+
+	void operator()(int i, const uint64_t* edges, int count) const
+	{
+		OutPixel* outRow = outBuffer + i * width + offset;
+		for (int w = 0; w * 64 < count; ++w) {
+			uint64_t word = edges[w];
+			int n = std::min(64, count - w * 64);
+			for (int b = 0; b < n; ++b)
+				outRow[w * 64 + b] = (word >> b) & 1 ? 255 : 0;
+		}
+	}
+};
+
+struct PackedSink {
+	PackedImage* out;
+	int offset;
+
+	void operator()(int i, const uint64_t* edges, int count) const
+	{
+		uint64_t* outRow = out->row(i);
+		int words = out->wordsPerRow;
+		int q = offset >> 6, r = offset & 63;
+		int lastWord = (count - 1) >> 6;
+		uint64_t lastMask = (count & 63) == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (count & 63)) - 1;
+		for (int w = words - 1; w >= 0; --w) {
+			uint64_t value = 0;
+			int source = w - q;
+			if (source >= 0 && source <= lastWord)
+				value |= (source == lastWord ? edges[source] & lastMask : edges[source]) << r;
+			if (r != 0 && source - 1 >= 0 && source - 1 <= lastWord)
+				value |= (source - 1 == lastWord ? edges[source - 1] & lastMask : edges[source - 1]) >> (64 - r);
+			outRow[w] = value;
+		}
+	}
+};
+
+template<typename InPixel, typename Sink>
+void binaryEdges(InPixel* inBuffer, int width, int height, int lookupWidth, int rowStart, int rowEnd, const Sink& sink)
+{
+	int offset = lookupWidth / 2;
+	int count = width - 2 * offset;
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
+	if (rowStart >= rowEnd || count <= 0)
+		return;
+
+	int words = (width + 63) / 64;
+	std::vector<uint64_t> packed(words), edges(words);
+	std::vector<uint64_t> anyLines((size_t)lookupWidth * words), allLines((size_t)lookupWidth * words);
+
+	// window of output row i is rows i - offset .. i - offset + lookupWidth - 1, one row less below it for even widths
+	int below = lookupWidth - 1 - offset;
+	for (int r = rowStart - offset; r < rowEnd + below; ++r) {
+		int slot = r % lookupWidth;
+		packRow(inBuffer + r * width, &packed[0], width);
+		windowReduce(&packed[0], &anyLines[(size_t)slot * words], words, lookupWidth, OrOp());
+		windowReduce(&packed[0], &allLines[(size_t)slot * words], words, lookupWidth, AndOp());
+
+		if (r < rowStart + below)
+			continue;
+
+		// ring holds exactly the lookupWidth rows of output row r - below
+		for (int w = 0; w < words; ++w) {
+			uint64_t any = 0, all = ~(uint64_t)0;
+			for (int k = 0; k < lookupWidth; ++k) {
+				any |= anyLines[(size_t)k * words + w];
+				all &= allLines[(size_t)k * words + w];
+			}
+			edges[w] = any & ~all;
+		}
+		sink(r - below, &edges[0], count);
+	}
+}
+
+void putWord(FILE* file, uint16_t value)
+{
+	unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+	fwrite(bytes, 1, 2, file);
+}
+
+void putDword(FILE* file, uint32_t value)
+{
+	unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+	fwrite(bytes, 1, 4, file);
+}
+
+unsigned char reverseBits(unsigned char value)
+{
+	value = (unsigned char)(((value & 0xF0) >> 4) | ((value & 0x0F) << 4));
+	value = (unsigned char)(((value & 0xCC) >> 2) | ((value & 0x33) << 2));
+	return (unsigned char)(((value & 0xAA) >> 1) | ((value & 0x55) << 1));
+}
+
+}
+
+void PackedImage::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	wordsPerRow = (width + 63) / 64;
+	bits.assign((size_t)wordsPerRow * height, 0);
+}
+
+template<typename InPixel>
+void packThreshold(const InPixel* inBuffer, PackedImage& mask, int rowStart, int rowEnd)
+{
+	for (int i = rowStart; i < rowEnd; ++i)
+		packRow(inBuffer + i * mask.width, mask.row(i), mask.width);
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_binary_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd)
+{
+	PixelSink<OutPixel> sink = { outBuffer, width, lookupWidth / 2 };
+	binaryEdges(inBuffer, width, height, lookupWidth, rowStart, rowEnd, sink);
+}
+
+template<typename InPixel>
+void filter_binary_edge_detection(InPixel* inBuffer, PackedImage& out, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd)
+{
+	PackedSink sink = { &out, lookupWidth / 2 };
+	binaryEdges(inBuffer, width, height, lookupWidth, rowStart, rowEnd, sink);
+}
+
+bool writePackedBitmap(const char* filename, const PackedImage& image)
+{
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+
+	uint32_t rowSize = (uint32_t)((image.width + 31) / 32) * 4;
+	uint32_t dataOffset = 14 + 40 + 2 * 4;
+	uint32_t dataSize = rowSize * image.height;
+
+	// file header
+	putWord(file, 0x4D42);
+	putDword(file, dataOffset + dataSize);
+	putWord(file, 0);
+	putWord(file, 0);
+	putDword(file, dataOffset);
+
+	// info header
+	putDword(file, 40);
+	putDword(file, (uint32_t)image.width);
+	putDword(file, (uint32_t)image.height);
+	putWord(file, 1);
+	putWord(file, 1);
+	putDword(file, 0);
+	putDword(file, dataSize);
+	putDword(file, 3780);
+	putDword(file, 3780);
+	putDword(file, 2);
+	putDword(file, 2);
+
+	// black and white color table
+	putDword(file, 0x00000000);
+	putDword(file, 0x00FFFFFF);
+
+	// rows bottom up, most significant bit is the leftmost pixel, bits past width in the last byte are 0
+	std::vector<unsigned char> line(rowSize);
+	int lineBytes = (image.width + 7) / 8;
+	unsigned char lastMask = (unsigned char)(0xFF << ((8 - image.width % 8) % 8));
+	for (int i = image.height - 1; i >= 0; --i) {
+		const uint64_t* row = image.row(i);
+		for (int b = 0; b < lineBytes; ++b)
+			line[b] = reverseBits((unsigned char)(row[b / 8] >> ((b % 8) * 8)));
+		if (lineBytes > 0)
+			line[lineBytes - 1] &= lastMask;
+		if (fwrite(&line[0], 1, rowSize, file) != rowSize) {
+			fclose(file);
+			return false;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+template void packThreshold<uint8_t>(const uint8_t* inBuffer, PackedImage& mask, int rowStart, int rowEnd);
+template void packThreshold<int>(const int* inBuffer, PackedImage& mask, int rowStart, int rowEnd);
+template void filter_binary_edge_detection<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
+template void filter_binary_edge_detection<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
+template void filter_binary_edge_detection<uint8_t>(uint8_t* inBuffer, PackedImage& out, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
+template void filter_binary_edge_detection<int>(int* inBuffer, PackedImage& out, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
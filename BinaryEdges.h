@@ -0,0 +1,72 @@
+/*
+ * BinaryEdges.h
+ *
+ *  Edge detection on thresholded image packed into 64 bit words.
+ */
+
+#ifndef BINARYEDGES_H_
+#define BINARYEDGES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+* @brief Binary image, bit x % 64 of word x / 64 in a row is pixel x
+*/
+struct PackedImage {
+	int width;
+	int height;
+	int wordsPerRow;
+	std::vector<uint64_t> bits;
+
+	PackedImage() : width(0), height(0), wordsPerRow(0) {}
+	void resize(int width, int height);
+	uint64_t* row(int i) { return &bits[(size_t)i * wordsPerRow]; }
+	const uint64_t* row(int i) const { return &bits[(size_t)i * wordsPerRow]; }
+};
+
+/**
+* @brief Packs pixels >= 128 of rows rowStart .. rowEnd - 1 into mask
+* @param inBuffer buffer of input image
+* @param mask packed image of the same size as input image
+* @param rowStart first row to pack
+* @param rowEnd row after the last row to pack
+*/
+template<typename InPixel>
+void packThreshold(const InPixel* inBuffer, PackedImage& mask, int rowStart, int rowEnd);
+
+/**
+* @brief Edge detection algorithm on thresholded image packed 64 pixels per word. Window "any pixel
+* >= 128" and "all pixels >= 128" are computed with shifts, ORs and ANDs, horizontally with log2(lookupWidth)
+* doubling steps and vertically across rows. Result is identical to filter_serial_edge_detection.
+* Instantiated for uint8_t and int pixels.
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_binary_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd);
+
+/**
+* @brief Same as filter_binary_edge_detection, but edges are stored as set bits of packed image
+* (which has to be of the image size) and are not unpacked
+*/
+template<typename InPixel>
+void filter_binary_edge_detection(InPixel* inBuffer, PackedImage& out, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd);
+
+/**
+* @brief Writes packed image as 1 bit per pixel bitmap, set bits are white
+* @param filename output file name
+* @param image packed image
+* @return true on success
+*/
+bool writePackedBitmap(const char* filename, const PackedImage& image);
+
+#endif /* BINARYEDGES_H_ */
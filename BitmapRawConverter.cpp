@@ -7,41 +7,176 @@
 
 
 #include "BitmapRawConverter.h"
+#include "BitmapRows.h"
+#include "MappedBitmap.h"
+#include "Trace.h"
 #include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
 
-BitmapRawConverter::BitmapRawConverter(char *filename) {
-	bitmap.ReadFromFile(filename);
+// mapped rows are decoded and encoded in parallel bands of about this many file bytes
+#define BAND_BYTES		(1 << 20)
+
+namespace {
+
+int bandRows(int rowBytes)
+{
+	return std::max(1, BAND_BYTES / rowBytes);
+}
+
+// decodes 24 and 32 bit file rows straight to the grayscale buffer
+template<typename Pixel>
+class LuminanceRowReader : public BMPrawRowReader {
+public:
+	Pixel *pixels;
+	int width;
+	int height;
+	int bytesPerPixel;
+	std::vector<char> rowRead;	// rows are decoded by several threads, each sets only its own flag
+
+	LuminanceRowReader() : pixels(NULL), width(0), height(0), bytesPerPixel(0) {};
+
+	bool SetSize(int Width, int Height, int BitDepth) {
+		width = Width;
+		height = Height;
+		bytesPerPixel = BitDepth / 8;
+		rowRead.assign(height, 0);
+		pixels = (Pixel *) malloc((size_t)width * height * sizeof(Pixel));
+		return pixels != NULL;
+	}
+
+	void ReadRow(const ebmpBYTE *Buffer, int Row) {
+		decodeLuminanceRow(Buffer, bytesPerPixel, pixels + (size_t)Row * width, width);
+		rowRead[Row] = 1;
+	}
+
+	// rows missing from a short file are white, like EasyBMP leaves them
+	void fillUnreadRows() {
+		for (int j = 0; j < height; j++)
+			if (!rowRead[j])
+				std::fill(pixels + (size_t)j * width, pixels + (size_t)(j + 1) * width, (Pixel)255);
+	}
+};
+
+}
+
+// 24 and 32 bit files are decoded and converted to grayscale in one pass, in place from the mapped file when it can
+// be mapped, bitmap stays empty. Bands of rows are decoded in parallel.
+template<typename Pixel>
+BitmapRawConverter<Pixel>::BitmapRawConverter(char *filename) : pixels(NULL) {
+	if (readMappedFile(filename))
+		return;
+
+	LuminanceRowReader<Pixel> reader;
+	bool read;
+	{
+		TRACE_SCOPE("read bitmap", TRACE_DECODE, 0, 0);
+		read = bitmap.ReadFromFile(filename, &reader);
+	}
+	if (reader.pixels != NULL) {
+		if (!read)
+			reader.fillUnreadRows();
+		pixels = reader.pixels;
+		width = reader.width;
+		height = reader.height;
+		return;
+	}
 	width = bitmap.TellWidth();
 	height = bitmap.TellHeight();
 
 	bitmapToPixels();
 }
 
-void BitmapRawConverter::bitmapToPixels() {
-	pixels = (int *) malloc(width * height * sizeof(int));  //new int[width * height];
+// image without bitmap file, pixels are set through getBuffer
+template<typename Pixel>
+BitmapRawConverter<Pixel>::BitmapRawConverter(int width, int height) : width(width), height(height) {
+	pixels = (Pixel *) calloc((size_t)width * height, sizeof(Pixel));
+}
+
+template<typename Pixel>
+bool BitmapRawConverter<Pixel>::readMappedFile(char *filename) {
+	TRACE_SCOPE("read mapped bitmap", TRACE_DECODE, 0, 0);
+	MappedBitmapReader file;
+	if (!file.open(filename))
+		return false;
+
+	width = file.getWidth();
+	height = file.getHeight();
+	pixels = (Pixel *) malloc((size_t)width * height * sizeof(Pixel));
+	int bytesPerPixel = file.getBitDepth() / 8;
+	tbb::parallel_for(tbb::blocked_range<int>(0, height, bandRows(width * bytesPerPixel)), [&](const tbb::blocked_range<int>& range) {
+		TRACE_SCOPE("decode band", TRACE_DECODE, range.begin(), range.end());
+		for (int j = range.begin(); j < range.end(); j++)
+			decodeLuminanceRow(file.getRow(j), bytesPerPixel, pixels + (size_t)j * width, width);
+	});
+	return true;
+}
+
+// keeps decoded bitmap for bitmapToPixels, grayscale buffer is not changed
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::readBitmap(char *filename) {
+	TRACE_SCOPE("read bitmap", TRACE_DECODE, 0, 0);
+	bitmap.ReadFromFile(filename);
+}
 
-	for (int i = 0; i < width; i++) {
-		for (int j = 0; j < height; j++) {
-			RGBApixel pxl = bitmap.GetPixel(i,j);
-			putPixel(i, j, pxl);
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::bitmapToPixels() {
+	TRACE_SCOPE("bitmap to pixels", TRACE_CONVERT, 0, height);
+	free(pixels);
+	width = bitmap.TellWidth();
+	height = bitmap.TellHeight();
+	pixels = (Pixel *) malloc(width * height * sizeof(Pixel));  //new Pixel[width * height];
+
+	for (int j = 0; j < height; j++) {
+		const RGBApixel *row = bitmap.GetRow(j);
+		for (int i = 0; i < width; i++) {
+			putPixel(i, j, row[i]);
 		}
 	}
 }
 
-void BitmapRawConverter::pixelsToBitmap(char *outFilename) {
+// 24 bit file is written in place through a mapping by parallel bands of rows, with EasyBMP if the file can not
+// be mapped
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::pixelsToBitmap(char *outFilename) {
+	{
+		TRACE_SCOPE("write mapped bitmap", TRACE_ENCODE, 0, height);
+		MappedBitmapWriter file;
+		if (file.create(outFilename, width, height, 24)) {
+			tbb::parallel_for(tbb::blocked_range<int>(0, height, bandRows(width * 3)), [&](const tbb::blocked_range<int>& range) {
+				TRACE_SCOPE("encode band", TRACE_ENCODE, range.begin(), range.end());
+				for (int j = range.begin(); j < range.end(); j++)
+					encodeGrayscaleRow(pixels + (size_t)j * width, file.getRow(j), 3, width);
+			});
+			return;
+		}
+	}
+
 	BMP out;
-	out.SetSize(width, height);
 	out.SetBitDepth(24);
+	pixelsToBitmap(out);
+	TRACE_SCOPE("write bitmap", TRACE_ENCODE, 0, height);
+	out.WriteToFile(outFilename);
+}
+
+// resizes out to the image, bit depth of out is kept
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::pixelsToBitmap(BMP &out) {
+	TRACE_SCOPE("pixels to bitmap", TRACE_CONVERT, 0, height);
+	out.SetSize(width, height);
 
-	for (int i = 0; i < width; i++) {
-		for (int j = 0; j < height; j++) {
-			out.SetPixel(i, j, getPixel(i,j));
+	for (int j = 0; j < height; j++) {
+		RGBApixel *row = out.GetRow(j);
+		for (int i = 0; i < width; i++) {
+			row[i] = getPixel(i, j);
 		}
 	}
-	out.WriteToFile(outFilename);
 }
 
-RGBApixel BitmapRawConverter::getPixel(int i, int j) {
+template<typename Pixel>
+RGBApixel BitmapRawConverter<Pixel>::getPixel(int i, int j) {
 	RGBApixel pxl;
 	int value = pixels[j * width + i];
 	pxl.Red = value;
@@ -51,41 +186,51 @@ RGBApixel BitmapRawConverter::getPixel(int i, int j) {
 	return pxl;
 }
 
-void BitmapRawConverter::putPixel(int i, int j, RGBApixel value) {
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::putPixel(int i, int j, RGBApixel value) {
 	pixels[j * width + i] = ((30 * value.Red) + (59 * value.Green) + (11 * value.Blue)) / 100;
 }
 
-int *BitmapRawConverter::getBuffer()
+template<typename Pixel>
+Pixel *BitmapRawConverter<Pixel>::getBuffer()
 {
 	return pixels;
 }
 
-void BitmapRawConverter::setBuffer(int *buffer)
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::setBuffer(Pixel *buffer)
 {
-	memcpy((void *)pixels, (void *)buffer, width * height * sizeof(int));
+	memcpy((void *)pixels, (void *)buffer, width * height * sizeof(Pixel));
 }
 
-int BitmapRawConverter::getHeight() const
+template<typename Pixel>
+int BitmapRawConverter<Pixel>::getHeight() const
 {
     return height;
 }
 
-int BitmapRawConverter::getWidth() const
+template<typename Pixel>
+int BitmapRawConverter<Pixel>::getWidth() const
 {
     return width;
 }
 
-void BitmapRawConverter::setHeight(int height)
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::setHeight(int height)
 {
     this->height = height;
 }
 
-void BitmapRawConverter::setWidth(int width)
+template<typename Pixel>
+void BitmapRawConverter<Pixel>::setWidth(int width)
 {
     this->width = width;
 }
 
-BitmapRawConverter::~BitmapRawConverter() {
-	delete pixels;
+template<typename Pixel>
+BitmapRawConverter<Pixel>::~BitmapRawConverter() {
+	free(pixels);
 }
 
+template class BitmapRawConverter<uint8_t>;
+template class BitmapRawConverter<int>;
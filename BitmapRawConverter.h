@@ -9,26 +9,37 @@
 #define BITMAPRAWCONVERTER_H_
 
 #include "EasyBMP.h"
+#include <stdint.h>
 
+/**
+* @brief Grayscale raw buffer of a bitmap, Pixel is the type of one buffer element
+* (instantiated for uint8_t and int)
+*/
+template<typename Pixel>
 class BitmapRawConverter {
 private:
 	BMP bitmap;
 	int width;
 	int height;
-	int *pixels;
+	Pixel *pixels;
+
+	bool readMappedFile(char *filename);
 public:
+	void readBitmap(char *filename);
 	void bitmapToPixels();
 	void pixelsToBitmap(char *outFilename);
+	void pixelsToBitmap(BMP &out);
 
 	RGBApixel getPixel(int i, int j);
 	void putPixel(int i, int j, RGBApixel value);
 
-	int *getBuffer();
-	void setBuffer(int *buffer);
+	Pixel *getBuffer();
+	void setBuffer(Pixel *buffer);
 
 
 
 	BitmapRawConverter(char *filename);
+	BitmapRawConverter(int width, int height);
 	virtual ~BitmapRawConverter();
     int getHeight() const;
     int getWidth() const;
@@ -0,0 +1,176 @@
+/*
+ * BitmapRows.cpp
+ *
+ *  Vectorized decoding and encoding of whole 24 and 32 bit bitmap file rows.
+ */
+
+#include "BitmapRows.h"
+#include "SimdPrewitt.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TARGET_SSE41
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+// x / 100 == (x * 5243) >> 19 for every weighted sum x <= 100 * 255
+#define DIVIDE_100_MULTIPLIER	5243
+#define DIVIDE_100_SHIFT		19
+
+namespace {
+
+inline int luminance(const uint8_t* pixel)
+{
+	return (30 * pixel[2] + 59 * pixel[1] + 11 * pixel[0]) / 100;
+}
+
+#ifdef SIMD_X86
+
+// blue, green, red of 4 packed pixels to 4 byte pixels with zero alpha
+TARGET_SSE41 inline __m128i spreadBgr(__m128i packed)
+{
+	return _mm_shuffle_epi8(packed, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+}
+
+// weighted sums of 4 blue, green, red, alpha pixels, pairs of bytes are summed to words and words to doublewords
+TARGET_SSE41 inline __m128i weightedSums(__m128i pixels)
+{
+	__m128i words = _mm_maddubs_epi16(pixels, _mm_setr_epi8(11, 59, 30, 0, 11, 59, 30, 0, 11, 59, 30, 0, 11, 59, 30, 0));
+	return _mm_madd_epi16(words, _mm_set1_epi16(1));
+}
+
+TARGET_SSE41 inline void store8x16(uint8_t* pixel, __m128i words)
+{
+	_mm_storel_epi64((__m128i*)pixel, _mm_packus_epi16(words, words));
+}
+
+TARGET_SSE41 inline void store8x16(int* pixel, __m128i words)
+{
+	_mm_storeu_si128((__m128i*)pixel, _mm_cvtepu16_epi32(words));
+	_mm_storeu_si128((__m128i*)(pixel + 4), _mm_cvtepu16_epi32(_mm_srli_si128(words, 8)));
+}
+
+TARGET_SSE41 int sse41BgrRow(const uint8_t* source, RGBApixel* row, int width)
+{
+	// 16 bytes are loaded for 4 pixels, so the last 2 pixels are left to the scalar loop
+	int x = 0;
+	for (; x + 6 <= width; x += 4)
+		_mm_storeu_si128((__m128i*)(row + x), spreadBgr(_mm_loadu_si128((const __m128i*)(source + 3 * x))));
+	return x;
+}
+
+template<typename Pixel>
+TARGET_SSE41 int sse41LuminanceRow(const uint8_t* source, int bytesPerPixel, Pixel* row, int width)
+{
+	const __m128i multiplier = _mm_set1_epi16(DIVIDE_100_MULTIPLIER);
+	int x = 0;
+	for (; (x + 8) * bytesPerPixel + 4 <= width * bytesPerPixel; x += 8) {
+		const uint8_t* pixel = source + x * bytesPerPixel;
+		__m128i low = _mm_loadu_si128((const __m128i*)pixel);
+		__m128i high = _mm_loadu_si128((const __m128i*)(pixel + 4 * bytesPerPixel));
+		if (bytesPerPixel == 3) {
+			low = spreadBgr(low);
+			high = spreadBgr(high);
+		}
+		__m128i sums = _mm_packs_epi32(weightedSums(low), weightedSums(high));
+		store8x16(row + x, _mm_srli_epi16(_mm_mulhi_epu16(sums, multiplier), DIVIDE_100_SHIFT - 16));
+	}
+	return x;
+}
+
+// 16 grayscale pixels as bytes, int values are truncated like the scalar conversion
+TARGET_SSE41 inline __m128i load16x8(const uint8_t* pixel)
+{
+	return _mm_loadu_si128((const __m128i*)pixel);
+}
+
+TARGET_SSE41 inline __m128i load16x8(const int* pixel)
+{
+	const __m128i byteMask = _mm_set1_epi32(255);
+	__m128i low = _mm_packus_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)pixel), byteMask),
+		_mm_and_si128(_mm_loadu_si128((const __m128i*)(pixel + 4)), byteMask));
+	__m128i high = _mm_packus_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(pixel + 8)), byteMask),
+		_mm_and_si128(_mm_loadu_si128((const __m128i*)(pixel + 12)), byteMask));
+	return _mm_packus_epi16(low, high);
+}
+
+template<typename Pixel>
+TARGET_SSE41 int sse41GrayscaleRow(const Pixel* row, uint8_t* destination, int bytesPerPixel, int width)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i gray = load16x8(row + x);
+		__m128i* pixel = (__m128i*)(destination + x * bytesPerPixel);
+		if (bytesPerPixel == 3) {
+			_mm_storeu_si128(pixel, _mm_shuffle_epi8(gray, _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5)));
+			_mm_storeu_si128(pixel + 1, _mm_shuffle_epi8(gray, _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10)));
+			_mm_storeu_si128(pixel + 2, _mm_shuffle_epi8(gray, _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15)));
+		}
+		else {
+			// zero alpha from the -1 shuffle indices
+			_mm_storeu_si128(pixel, _mm_shuffle_epi8(gray, _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1)));
+			_mm_storeu_si128(pixel + 1, _mm_shuffle_epi8(gray, _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1)));
+			_mm_storeu_si128(pixel + 2, _mm_shuffle_epi8(gray, _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1)));
+			_mm_storeu_si128(pixel + 3, _mm_shuffle_epi8(gray, _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)));
+		}
+	}
+	return x;
+}
+
+#endif
+
+}
+
+void decodeBgrRow(const uint8_t* source, RGBApixel* row, int width)
+{
+	int x = 0;
+#ifdef SIMD_X86
+	if (detectSimdLevel() != SIMD_SCALAR)
+		x = sse41BgrRow(source, row, width);
+#endif
+	for (; x < width; ++x) {
+		row[x].Blue = source[3 * x];
+		row[x].Green = source[3 * x + 1];
+		row[x].Red = source[3 * x + 2];
+		row[x].Alpha = 0;
+	}
+}
+
+template<typename Pixel>
+void decodeLuminanceRow(const uint8_t* source, int bytesPerPixel, Pixel* row, int width)
+{
+	int x = 0;
+#ifdef SIMD_X86
+	if (detectSimdLevel() != SIMD_SCALAR)
+		x = sse41LuminanceRow(source, bytesPerPixel, row, width);
+#endif
+	for (; x < width; ++x)
+		row[x] = (Pixel)luminance(source + x * bytesPerPixel);
+}
+
+template void decodeLuminanceRow<uint8_t>(const uint8_t* source, int bytesPerPixel, uint8_t* row, int width);
+template void decodeLuminanceRow<int>(const uint8_t* source, int bytesPerPixel, int* row, int width);
+
+template<typename Pixel>
+void encodeGrayscaleRow(const Pixel* row, uint8_t* destination, int bytesPerPixel, int width)
+{
+	int x = 0;
+#ifdef SIMD_X86
+	if (detectSimdLevel() != SIMD_SCALAR)
+		x = sse41GrayscaleRow(row, destination, bytesPerPixel, width);
+#endif
+	for (; x < width; ++x) {
+		uint8_t* pixel = destination + x * bytesPerPixel;
+		pixel[0] = pixel[1] = pixel[2] = (uint8_t)row[x];
+		if (bytesPerPixel == 4)
+			pixel[3] = 0;
+	}
+}
+
+template void encodeGrayscaleRow<uint8_t>(const uint8_t* row, uint8_t* destination, int bytesPerPixel, int width);
+template void encodeGrayscaleRow<int>(const int* row, uint8_t* destination, int bytesPerPixel, int width);
@@ -0,0 +1,45 @@
+/*
+ * BitmapRows.h
+ *
+ *  Vectorized decoding and encoding of whole 24 and 32 bit bitmap file rows.
+ */
+
+#ifndef BITMAPROWS_H_
+#define BITMAPROWS_H_
+
+#include "EasyBMP.h"
+#include <stdint.h>
+
+/**
+* @brief Decodes 24 bit row (blue, green, red bytes per pixel) to pixels with alpha 0, 4 pixels per shuffle when
+* SSE4.1 is supported
+* @param source row as stored in the file
+* @param row decoded pixels
+* @param width number of pixels in row
+*/
+void decodeBgrRow(const uint8_t* source, RGBApixel* row, int width);
+
+/**
+* @brief Decodes 24 or 32 bit row straight to grayscale (30 * red + 59 * green + 11 * blue) / 100, same as
+* BitmapRawConverter::putPixel. With SSE4.1 8 pixels are weighted and divided at once in 16 bit lanes.
+* Instantiated for uint8_t and int pixels.
+* @param source row as stored in the file, blue, green, red and for 32 bit alpha byte per pixel
+* @param bytesPerPixel 3 or 4
+* @param row grayscale pixels
+* @param width number of pixels in row
+*/
+template<typename Pixel>
+void decodeLuminanceRow(const uint8_t* source, int bytesPerPixel, Pixel* row, int width);
+
+/**
+* @brief Encodes grayscale row as 24 or 32 bit file row, every channel gets the pixel value and alpha is 0.
+* With SSE4.1 16 pixels are spread by byte shuffles at once. Instantiated for uint8_t and int pixels.
+* @param row grayscale pixels
+* @param destination row as stored in the file
+* @param bytesPerPixel 3 or 4
+* @param width number of pixels in row
+*/
+template<typename Pixel>
+void encodeGrayscaleRow(const Pixel* row, uint8_t* destination, int bytesPerPixel, int width);
+
+#endif /* BITMAPROWS_H_ */
@@ -0,0 +1,71 @@
+/*
+ * CacheTiling.cpp
+ *
+ *  Tile shape for 2D blocked processing chosen from data cache sizes and kernel halo.
+ */
+
+#include "CacheTiling.h"
+#include <algorithm>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define DEFAULT_L1_SIZE			(32 * 1024)
+#define DEFAULT_L2_SIZE			(256 * 1024)
+#define TILE_COLUMN_STEP		64
+
+namespace {
+
+size_t queryCacheSize(int level)
+{
+#ifdef _WIN32
+	DWORD length = 0;
+	GetLogicalProcessorInformation(NULL, &length);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION) + 1);
+	if (!GetLogicalProcessorInformation(&info[0], &length))
+		return 0;
+	for (size_t k = 0; k < length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION); ++k) {
+		const CACHE_DESCRIPTOR& cache = info[k].Cache;
+		if (info[k].Relationship == RelationCache && cache.Level == level && (cache.Type == CacheData || cache.Type == CacheUnified))
+			return cache.Size;
+	}
+	return 0;
+#elif defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+	long size = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+	return size > 0 ? (size_t)size : 0;
+#else
+	return 0;
+#endif
+}
+
+}
+
+size_t dataCacheSize(int level)
+{
+	static const size_t l1 = queryCacheSize(1), l2 = queryCacheSize(2);
+	if (level <= 1)
+		return l1 ? l1 : DEFAULT_L1_SIZE;
+	return l2 ? l2 : DEFAULT_L2_SIZE;
+}
+
+TileShape chooseTileShape(int width, int height, int kernelSize, int inPixelSize, int outPixelSize)
+{
+	long halo = kernelSize / 2;
+	long l1 = (long)dataCacheSize(1) / 2, l2 = (long)dataCacheSize(2) / 2;
+
+	// kernelSize * (columns + 2 * halo) * inPixelSize + columns * outPixelSize <= l1
+	long columns = (l1 - 2 * halo * kernelSize * inPixelSize) / (kernelSize * inPixelSize + outPixelSize);
+	columns = columns / TILE_COLUMN_STEP * TILE_COLUMN_STEP;
+	columns = std::min<long>(std::max<long>(columns, TILE_COLUMN_STEP), width);
+
+	// (rows + 2 * halo) * (columns + 2 * halo) * inPixelSize + rows * columns * outPixelSize <= l2
+	long inLine = (columns + 2 * halo) * inPixelSize;
+	long rows = (l2 - 2 * halo * inLine) / (inLine + columns * outPixelSize);
+	rows = std::min<long>(std::max<long>(rows, 1), height);
+
+	TileShape tile = { (int)std::max<long>(rows, 1), (int)std::max<long>(columns, 1) };
+	return tile;
+}
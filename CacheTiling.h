@@ -0,0 +1,39 @@
+/*
+ * CacheTiling.h
+ *
+ *  Tile shape for 2D blocked processing chosen from data cache sizes and kernel halo.
+ */
+
+#ifndef CACHETILING_H_
+#define CACHETILING_H_
+
+#include <stddef.h>
+
+/**
+* @brief Output pixels processed by one task of tiled version
+*/
+struct TileShape {
+	int rows;
+	int columns;
+};
+
+/**
+* @brief Size of data (or unified) cache of given level in bytes, queried from operating system once.
+* If it can not be found 32 KB for level 1 and 256 KB for level 2 are assumed.
+* @param level cache level, 1 or 2
+*/
+size_t dataCacheSize(int level);
+
+/**
+* @brief Chooses tile shape so that kernelSize input rows of tile width (with halo) and one output row
+* take at most half of L1 cache, which keeps vertical reuse between neighbouring rows in L1, and the whole
+* input and output tile take at most half of L2 cache. Columns are multiple of 64 pixels.
+* @param width image width
+* @param height image height
+* @param kernelSize size of the filter or lookup window
+* @param inPixelSize size of input pixel in bytes
+* @param outPixelSize size of output pixel in bytes
+*/
+TileShape chooseTileShape(int width, int height, int kernelSize, int inPixelSize, int outPixelSize);
+
+#endif /* CACHETILING_H_ */
@@ -0,0 +1,131 @@
+/*
+ * CutOffModel.cpp
+ *
+ *  Cost model deciding when task based versions stop splitting work.
+ */
+
+#include "CutOffModel.h"
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <tbb/task_group.h>
+#include <tbb/tick_count.h>
+
+// spawning may take at most 1 / OVERHEAD_RATIO of a task
+#define OVERHEAD_RATIO			20
+#define TASKS_PER_THREAD		4
+#define CALIBRATION_RUNS		3
+#define TASK_CALIBRATION_COUNT	1000
+#define TASK_KEY				"task"
+
+namespace {
+
+typedef std::map<std::pair<std::string, int>, double> CostTable;
+
+CostTable& costs()
+{
+	static CostTable table;
+	return table;
+}
+
+std::mutex& costsMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+double measureTaskCost()
+{
+	double best = 0;
+	for (int run = 0; run < CALIBRATION_RUNS; ++run) {
+		auto start = tbb::tick_count::now();
+		tbb::task_group tg;
+		for (int k = 0; k < TASK_CALIBRATION_COUNT; ++k)
+			tg.run([]() {});
+		tg.wait();
+		double seconds = (tbb::tick_count::now() - start).seconds() / TASK_CALIBRATION_COUNT;
+		best = run == 0 ? seconds : std::min(best, seconds);
+	}
+	return best;
+}
+
+}
+
+bool loadCutOffCalibration(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+		return false;
+
+	std::lock_guard<std::mutex> lock(costsMutex());
+	char algorithm[64];
+	int kernelSize;
+	double seconds;
+	while (fscanf(file, "%63s %d %lf", algorithm, &kernelSize, &seconds) == 3)
+		if (seconds > 0)
+			costs()[std::make_pair(std::string(algorithm), kernelSize)] = seconds;
+	fclose(file);
+	return true;
+}
+
+bool saveCutOffCalibration(const char* filename)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	std::lock_guard<std::mutex> lock(costsMutex());
+	for (CostTable::const_iterator it = costs().begin(); it != costs().end(); ++it)
+		fprintf(file, "%s %d %.6g\n", it->first.first.c_str(), it->first.second, it->second);
+	return fclose(file) == 0;
+}
+
+double pixelCost(const std::string& algorithm, int kernelSize)
+{
+	std::lock_guard<std::mutex> lock(costsMutex());
+	CostTable::const_iterator it = costs().find(std::make_pair(algorithm, kernelSize));
+	return it != costs().end() ? it->second : 0;
+}
+
+bool calibratePixelCost(const std::string& algorithm, int kernelSize, const std::function<void()>& run, long pixels)
+{
+	if (pixelCost(algorithm, kernelSize) > 0)
+		return false;
+
+	// first run only warms up caches
+	run();
+	double best = 0;
+	for (int k = 0; k < CALIBRATION_RUNS; ++k) {
+		auto start = tbb::tick_count::now();
+		run();
+		double seconds = (tbb::tick_count::now() - start).seconds();
+		best = k == 0 ? seconds : std::min(best, seconds);
+	}
+
+	std::lock_guard<std::mutex> lock(costsMutex());
+	costs()[std::make_pair(algorithm, kernelSize)] = std::max(best / pixels, 1e-12);
+	return true;
+}
+
+double taskCost()
+{
+	double seconds = pixelCost(TASK_KEY, 0);
+	if (seconds > 0)
+		return seconds;
+
+	seconds = std::max(measureTaskCost(), 1e-9);
+	std::lock_guard<std::mutex> lock(costsMutex());
+	costs()[std::make_pair(std::string(TASK_KEY), 0)] = seconds;
+	return seconds;
+}
+
+long leafPixels(double pixelCost, long totalPixels, int threads)
+{
+	if (pixelCost <= 0)
+		return -1;
+	long overheadPixels = (long)(taskCost() * OVERHEAD_RATIO / pixelCost);
+	long balancePixels = totalPixels / ((long)std::max(threads, 1) * TASKS_PER_THREAD);
+	return std::max(std::max(overheadPixels, balancePixels), 1L);
+}
@@ -0,0 +1,59 @@
+/*
+ * CutOffModel.h
+ *
+ *  Cost model deciding when task based versions stop splitting work.
+ */
+
+#ifndef CUTOFFMODEL_H_
+#define CUTOFFMODEL_H_
+
+#include <functional>
+#include <string>
+
+/**
+* @brief Loads measured costs from calibration file, lines are "algorithm kernelSize seconds"
+* @param filename calibration file name
+* @return false if file can not be read
+*/
+bool loadCutOffCalibration(const char* filename);
+
+/**
+* @brief Saves all measured costs to calibration file
+* @param filename calibration file name
+* @return false if file can not be written
+*/
+bool saveCutOffCalibration(const char* filename);
+
+/**
+* @brief Cost of one output pixel in seconds, 0 if it was not measured
+* @param algorithm name of the algorithm
+* @param kernelSize size of the filter or lookup window
+*/
+double pixelCost(const std::string& algorithm, int kernelSize);
+
+/**
+* @brief Measures cost of one output pixel as the best of a few timed runs, unless it is already known
+* @param algorithm name of the algorithm
+* @param kernelSize size of the filter or lookup window
+* @param run computes pixels output pixels
+* @param pixels number of pixels computed by run
+* @return true if cost was measured, false if it was already known
+*/
+bool calibratePixelCost(const std::string& algorithm, int kernelSize, const std::function<void()>& run, long pixels);
+
+/**
+* @brief Cost of spawning and joining one task_group task in seconds, measured on first use unless known
+*/
+double taskCost();
+
+/**
+* @brief Number of output pixels a task should get before it stops splitting. Task has to cost enough that
+* spawning it is a small part of its time, and there should be a few tasks per thread for balancing.
+* @param pixelCost cost of one output pixel, see pixelCost
+* @param totalPixels number of output pixels of the whole job
+* @param threads number of worker threads
+* @return number of pixels, -1 if pixel cost is not known
+*/
+long leafPixels(double pixelCost, long totalPixels, int threads);
+
+#endif /* CUTOFFMODEL_H_ */
@@ -19,10 +19,129 @@
 *************************************************/
 
 #include "EasyBMP.h"
+#include "BitmapRows.h"
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* Pixel storage of BMP, aligned so that rows of widths divisible by 16 start on cache lines */
+
+#define EasyBMPpixelAlignment 64
+
+static RGBApixel* AllocatePixels( size_t Count )
+{
+ void* Memory = NULL;
+ size_t Size = Count*sizeof(RGBApixel);
+#ifdef _MSC_VER
+ Memory = _aligned_malloc( Size , EasyBMPpixelAlignment );
+#else
+ if( posix_memalign( &Memory , EasyBMPpixelAlignment , Size ) != 0 )
+ { Memory = NULL; }
+#endif
+ if( !Memory )
+ { throw std::bad_alloc(); }
+ return (RGBApixel*) Memory;
+}
+
+static void FreePixels( RGBApixel* Pixels )
+{
+#ifdef _MSC_VER
+ _aligned_free( Pixels );
+#else
+ free( Pixels );
+#endif
+}
+
+/* Rows of 1, 4, 8, 24 and 32 bit files are read and written in bands of about 
+   EasyBMPbandBytes bytes, every band at its own offset on a TBB worker thread */
+
+#define EasyBMPbandBytes (1 << 20)
+
+// positional read that leaves the stdio position alone, returns number of bytes read
+static size_t ReadAt( FILE* fp, ebmpBYTE* Buffer, size_t Size, long long Offset )
+{
+ size_t Done = 0;
+ while( Done < Size )
+ {
+#ifdef _WIN32
+  OVERLAPPED Position = {};
+  Position.Offset = (DWORD) ( Offset + Done );
+  Position.OffsetHigh = (DWORD) ( ( Offset + Done ) >> 32 );
+  DWORD Count = 0;
+  if( !ReadFile( (HANDLE) _get_osfhandle( _fileno(fp) ), Buffer + Done, (DWORD) ( Size - Done ), &Count, &Position ) )
+  { Count = 0; }
+#else
+  ssize_t Count = pread( fileno(fp), Buffer + Done, Size - Done, (off_t) ( Offset + Done ) );
+#endif
+  if( Count <= 0 )
+  { break; }
+  Done += (size_t) Count;
+ }
+ return Done;
+}
+
+static bool WriteAt( FILE* fp, const ebmpBYTE* Buffer, size_t Size, long long Offset )
+{
+ size_t Done = 0;
+ while( Done < Size )
+ {
+#ifdef _WIN32
+  OVERLAPPED Position = {};
+  Position.Offset = (DWORD) ( Offset + Done );
+  Position.OffsetHigh = (DWORD) ( ( Offset + Done ) >> 32 );
+  DWORD Count = 0;
+  if( !WriteFile( (HANDLE) _get_osfhandle( _fileno(fp) ), Buffer + Done, (DWORD) ( Size - Done ), &Count, &Position ) )
+  { Count = 0; }
+#else
+  ssize_t Count = pwrite( fileno(fp), Buffer + Done, Size - Done, (off_t) ( Offset + Done ) );
+#endif
+  if( Count <= 0 )
+  { return false; }
+  Done += (size_t) Count;
+ }
+ return true;
+}
+
+// Band( FirstRow, Rows, Buffer ) handles file rows FirstRow.. (bottom-up), Buffer is reused
+// by the bands of one task. False from any band makes the result false.
+template<typename BandFunction>
+static bool ForEachRowBand( int RowCount, int RowBytes, const BandFunction& Band )
+{
+ int BandRows = std::max( 1, EasyBMPbandBytes / RowBytes );
+ std::atomic<bool> Success( true );
+ tbb::parallel_for( tbb::blocked_range<int>( 0, RowCount, BandRows ), 
+  [&]( const tbb::blocked_range<int>& Range )
+  {
+   std::vector<ebmpBYTE> Buffer;
+   for( int FirstRow = Range.begin() ; FirstRow < Range.end() ; FirstRow += BandRows )
+   {
+    if( !Band( FirstRow, std::min( BandRows, Range.end()-FirstRow ), Buffer ) )
+    { Success = false; }
+   }
+  } );
+ return Success;
+}
 
 /* These functions are defined in EasyBMP.h */
 
-bool EasyBMPwarnings = true;
+// read by worker threads, every message is printed whole while holding EasyBMPoutputMutex 
+std::atomic<bool> EasyBMPwarnings( true );
+static std::mutex EasyBMPoutputMutex;
 
 void SetEasyBMPwarningsOff( void )
 { EasyBMPwarnings = false; }
@@ -127,16 +246,17 @@ RGBApixel BMP::GetPixel( int i, int j ) const
  { j = 0; Warn = true; }
  if( Warn && EasyBMPwarnings )
  {
+  std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
   cout << "EasyBMP Warning: Attempted to access non-existent pixel;" << endl
        << "                 Truncating request to fit in the range [0,"
        << Width-1 << "] x [0," << Height-1 << "]." << endl;
  }	
- return Pixels[i][j];
+ return GetRow(j)[i];
 }
 
 bool BMP::SetPixel( int i, int j, RGBApixel NewPixel )
 {
- Pixels[i][j] = NewPixel;
+ GetRow(j)[i] = NewPixel;
  return true;
 }
 
@@ -148,6 +268,7 @@ bool BMP::SetColor( int ColorNumber , RGBApixel NewColor )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Attempted to change color table for a BMP object" << endl
         << "                 that lacks a color table. Ignoring request." << endl;
   }
@@ -157,6 +278,7 @@ bool BMP::SetColor( int ColorNumber , RGBApixel NewColor )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Attempted to set a color, but the color table" << endl
         << "                 is not defined. Ignoring request." << endl; 
   }
@@ -166,6 +288,7 @@ bool BMP::SetColor( int ColorNumber , RGBApixel NewColor )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Requested color number " 
         << ColorNumber << " is outside the allowed" << endl
         << "                 range [0," << TellNumberOfColors()-1 
@@ -191,6 +314,7 @@ RGBApixel BMP::GetColor( int ColorNumber )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Attempted to access color table for a BMP object" << endl
         << "                 that lacks a color table. Ignoring request." << endl;
   }
@@ -200,6 +324,7 @@ RGBApixel BMP::GetColor( int ColorNumber )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Requested a color, but the color table" << endl
         << "                 is not defined. Ignoring request." << endl;
   }
@@ -209,6 +334,7 @@ RGBApixel BMP::GetColor( int ColorNumber )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Requested color number " 
         << ColorNumber << " is outside the allowed" << endl
         << "                 range [0," << TellNumberOfColors()-1 
@@ -225,8 +351,7 @@ BMP::BMP()
  Width = 1;
  Height = 1;
  BitDepth = 24;
- Pixels = new RGBApixel* [Width];
- Pixels[0] = new RGBApixel [Height];
+ Pixels = AllocatePixels( (size_t) Width*Height );
  Colors = NULL;
  
  XPelsPerMeter = 0;
@@ -246,8 +371,7 @@ BMP::BMP( BMP& Input )
  Width = 1;
  Height = 1;
  BitDepth = 24;
- Pixels = new RGBApixel* [Width];
- Pixels[0] = new RGBApixel [Height];
+ Pixels = AllocatePixels( (size_t) Width*Height );
  Colors = NULL; 
  XPelsPerMeter = 0;
  YPelsPerMeter = 0;
@@ -282,22 +406,12 @@ BMP::BMP( BMP& Input )
  
  // get all the pixels 
  
- for( int j=0; j < Height ; j++ )
- {
-  for( int i=0; i < Width ; i++ )
-  {
-   Pixels[i][j] = *Input(i,j);
-//   Pixels[i][j] = Input.GetPixel(i,j); // *Input(i,j);
-  }
- }
+ memcpy( (char*) Pixels, (char*) Input.GetRow(0), (size_t) Width*Height*sizeof(RGBApixel) );
 }
 
 BMP::~BMP()
 {
- int i;
- for(i=0;i<Width;i++)
- { delete [] Pixels[i]; }
- delete [] Pixels;
+ FreePixels( Pixels );
  if( Colors )
  { delete [] Colors; }
  
@@ -321,11 +435,12 @@ RGBApixel* BMP::operator()(int i, int j)
  { j = 0; Warn = true; }
  if( Warn && EasyBMPwarnings )
  {
+  std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
   cout << "EasyBMP Warning: Attempted to access non-existent pixel;" << endl
        << "                 Truncating request to fit in the range [0,"
        << Width-1 << "] x [0," << Height-1 << "]." << endl;
  }	
- return &(Pixels[i][j]);
+ return &(GetRow(j)[i]);
 }
 
 // int BMP::TellBitDepth( void ) const
@@ -358,6 +473,7 @@ bool BMP::SetBitDepth( int NewDepth )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: User attempted to set unsupported bit depth " 
         << NewDepth << "." << endl
         << "                 Bit depth remains unchanged at " 
@@ -387,6 +503,7 @@ bool BMP::SetSize(int NewWidth , int NewHeight )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: User attempted to set a non-positive width or height." << endl
         << "                 Size remains unchanged at " 
         << Width << " x " << Height << "." << endl;
@@ -394,29 +511,24 @@ bool BMP::SetSize(int NewWidth , int NewHeight )
   return false;
  }
 
- int i,j; 
-
- for(i=0;i<Width;i++)
- { delete [] Pixels[i]; }
- delete [] Pixels;
-
- Width = NewWidth;
- Height = NewHeight;
- Pixels = new RGBApixel* [ Width ]; 
- 
- for(i=0; i<Width; i++)
- { Pixels[i] = new RGBApixel [ Height ]; }
+ // one allocation for the whole image, kept when the pixel count is unchanged
  
- for( i=0 ; i < Width ; i++)
+ if( (size_t) NewWidth*NewHeight != (size_t) Width*Height )
  {
-  for( j=0 ; j < Height ; j++ )
-  {
-   Pixels[i][j].Red = 255; 
-   Pixels[i][j].Green = 255; 
-   Pixels[i][j].Blue = 255; 
-   Pixels[i][j].Alpha = 0;    
-  }
+  FreePixels( Pixels );
+  Pixels = AllocatePixels( (size_t) NewWidth*NewHeight );
  }
+ Width = NewWidth;
+ Height = NewHeight;
+ 
+ RGBApixel White;
+ White.Red = 255; 
+ White.Green = 255; 
+ White.Blue = 255; 
+ White.Alpha = 0;    
+ size_t Count = (size_t) Width*Height;
+ for( size_t k=0 ; k < Count ; k++ )
+ { Pixels[k] = White; }
 
  return true; 
 }
@@ -428,6 +540,7 @@ bool BMP::WriteToFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Data types are wrong size!" << endl
         << "               You may need to mess with EasyBMP_DataTypes.h" << endl
 	    << "               to fix these errors, and then recompile." << endl
@@ -442,6 +555,7 @@ bool BMP::WriteToFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Cannot open file " 
         << FileName << " for output." << endl;
   }
@@ -549,54 +663,33 @@ bool BMP::WriteToFile( const char* FileName )
   { fwrite( (char*) &(Colors[n]) , 4 , 1 , fp ); }
  }
  
- // write the pixels 
+ // write the pixels, bands of rows are encoded in parallel and written at their offsets 
  int i,j;
  if( BitDepth != 16 )
  {  
-  ebmpBYTE* Buffer;
   int BufferSize = (int) ( (Width*BitDepth)/8.0 );
   while( 8*BufferSize < Width*BitDepth )
   { BufferSize++; }
   while( BufferSize % 4 )
   { BufferSize++; }
   
-  Buffer = new ebmpBYTE [BufferSize];
-  for( j=0 ; j < BufferSize; j++ )
-  { Buffer[j] = 0; }
-    
-  j=Height-1;
-  
-  while( j > -1 )
-  {
-   bool Success = false;
-   if( BitDepth == 32 )
-   { Success = Write32bitRow( Buffer, BufferSize, j ); }
-   if( BitDepth == 24 )
-   { Success = Write24bitRow( Buffer, BufferSize, j ); }
-   if( BitDepth == 8  )
-   { Success = Write8bitRow( Buffer, BufferSize, j ); }
-   if( BitDepth == 4  )
-   { Success = Write4bitRow( Buffer, BufferSize, j ); }
-   if( BitDepth == 1  )
-   { Success = Write1bitRow( Buffer, BufferSize, j ); }
-   if( Success )
+  fflush( fp );
+  long long DataStart = ftell( fp );
+  bool Success = ForEachRowBand( Height, BufferSize, 
+   [&]( int FirstRow, int Rows, std::vector<ebmpBYTE>& Buffer )
    {
-    int BytesWritten = (int) fwrite( (char*) Buffer, 1, BufferSize, fp );
-    if( BytesWritten != BufferSize )
-    { Success = false; }
-   }
-   if( !Success )
-   {
-    if( EasyBMPwarnings )
-    {
-     cout << "EasyBMP Error: Could not write proper amount of data." << endl;
-	}
-    j = -1; 
-   }
-   j--; 
+    Buffer.assign( (size_t) Rows*BufferSize, 0 );
+    bool BandSuccess = true;
+    for( int k=0 ; k < Rows && BandSuccess ; k++ )
+    { BandSuccess = WriteRow( &Buffer[(size_t) k*BufferSize], BufferSize, Height-1-FirstRow-k ); }
+    return BandSuccess && WriteAt( fp, &Buffer[0], Buffer.size(), DataStart + (long long) FirstRow*BufferSize );
+   } );
+  if( !Success && EasyBMPwarnings )
+  {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
+   cout << "EasyBMP Error: Could not write proper amount of data." << endl;
   }
-  
-  delete [] Buffer;
+  fseek( fp, 0, SEEK_END );
  }
  
  if( BitDepth == 16 )
@@ -637,9 +730,9 @@ bool BMP::WriteToFile( const char* FileName )
    {
     ebmpWORD TempWORD;
 	
-	ebmpWORD RedWORD = (ebmpWORD) ((Pixels[i][j]).Red / 8);
-	ebmpWORD GreenWORD = (ebmpWORD) ((Pixels[i][j]).Green / 4);
-	ebmpWORD BlueWORD = (ebmpWORD) ((Pixels[i][j]).Blue / 8);
+	ebmpWORD RedWORD = (ebmpWORD) (GetRow(j)[i].Red / 8);
+	ebmpWORD GreenWORD = (ebmpWORD) (GetRow(j)[i].Green / 4);
+	ebmpWORD BlueWORD = (ebmpWORD) (GetRow(j)[i].Blue / 8);
 	
     TempWORD = (RedWORD<<11) + (GreenWORD<<5) + BlueWORD;
 	if( IsBigEndian() )
@@ -666,12 +759,16 @@ bool BMP::WriteToFile( const char* FileName )
 }
 
 bool BMP::ReadFromFile( const char* FileName )
+{ return ReadFromFile( FileName, NULL ); }
+
+bool BMP::ReadFromFile( const char* FileName, BMPrawRowReader* RawReader )
 { 
  using namespace std;
  if( !EasyBMPcheckDataSize() )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Data types are wrong size!" << endl
         << "               You may need to mess with EasyBMP_DataTypes.h" << endl
 	    << "               to fix these errors, and then recompile." << endl
@@ -686,6 +783,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Cannot open file " 
         << FileName << " for input." << endl;
   }
@@ -712,6 +810,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName 
         << " is not a Windows BMP file!" << endl; 
   }
@@ -754,6 +853,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName 
         << " is obviously corrupted." << endl;
   }
@@ -772,6 +872,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName << " is (RLE) compressed." << endl
         << "               EasyBMP does not support compression." << endl;
   }
@@ -788,6 +889,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName << " is in an unsupported format." 
         << endl
         << "               (bmih.biCompression = " 
@@ -805,6 +907,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName 
         << " uses bit fields and is not a" << endl
         << "               16-bit file. This is not supported." << endl;
@@ -824,6 +927,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName << " has unrecognized bit depth." << endl;
   }
   SetSize(1,1);
@@ -839,6 +943,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: " << FileName 
         << " has a non-positive width or height." << endl;
   }
@@ -847,6 +952,16 @@ bool BMP::ReadFromFile( const char* FileName )
   fclose(fp);
   return false;
  } 
+ 
+ // raw rows go straight to the reader, nothing is stored in the BMP
+ 
+ if( RawReader && ( BitDepth == 24 || BitDepth == 32 ) )
+ {
+  SetSize(1,1);
+  bool Success = ReadRawRows( fp, (int) bmfh.bfOffBits - 54, (int) bmih.biWidth, (int) bmih.biHeight, RawReader );
+  fclose(fp);
+  return Success;
+ }
  SetSize( (int) bmih.biWidth , (int) bmih.biHeight );
   
  // some preliminaries
@@ -874,6 +989,7 @@ bool BMP::ReadFromFile( const char* FileName )
   {
    if( EasyBMPwarnings )
    {
+    std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
     cout << "EasyBMP Warning: file " << FileName << " has an underspecified" << endl
          << "                 color table. The table will be padded with extra" << endl
 	 	 << "                 white (255,255,255,0) entries." << endl;
@@ -911,6 +1027,7 @@ bool BMP::ReadFromFile( const char* FileName )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Extra meta data detected in file " << FileName << endl
         << "                 Data will be skipped." << endl;
   }
@@ -921,7 +1038,8 @@ bool BMP::ReadFromFile( const char* FileName )
  } 
   
  // This code reads 1, 4, 8, 24, and 32-bpp files 
- // with a more-efficient buffered technique.
+ // with a more-efficient buffered technique:
+ // bands of rows are read at their offsets and decoded in parallel.
 
  int i,j;
  if( BitDepth != 16 )
@@ -931,45 +1049,26 @@ bool BMP::ReadFromFile( const char* FileName )
   { BufferSize++; }
   while( BufferSize % 4 )
   { BufferSize++; }
-  ebmpBYTE* Buffer;
-  Buffer = new ebmpBYTE [BufferSize];
-  j= Height-1;
-  while( j > -1 )
-  {
-   int BytesRead = (int) fread( (char*) Buffer, 1, BufferSize, fp );
-   if( BytesRead < BufferSize )
+  long long DataStart = ftell( fp );
+  bool Success = ForEachRowBand( Height, BufferSize, 
+   [&]( int FirstRow, int Rows, std::vector<ebmpBYTE>& Buffer )
    {
-    j = -1; 
-    if( EasyBMPwarnings )
+    Buffer.resize( (size_t) Rows*BufferSize );
+    int RowsRead = (int) ( ReadAt( fp, &Buffer[0], Buffer.size(), DataStart + (long long) FirstRow*BufferSize ) / BufferSize );
+    // rows of a short band that were read are still decoded
+    bool RowsDecoded = true;
+    for( int k=0 ; k < RowsRead ; k++ )
     {
-     cout << "EasyBMP Error: Could not read proper amount of data." << endl;
-	}
-   }
-   else
-   {
-    bool Success = false;
-    if( BitDepth == 1  )
-	{ Success = Read1bitRow(  Buffer, BufferSize, j ); }
-    if( BitDepth == 4  )
-	{ Success = Read4bitRow(  Buffer, BufferSize, j ); }
-    if( BitDepth == 8  )
-	{ Success = Read8bitRow(  Buffer, BufferSize, j ); }
-    if( BitDepth == 24 )
-	{ Success = Read24bitRow( Buffer, BufferSize, j ); }
-	if( BitDepth == 32 )
-	{ Success = Read32bitRow( Buffer, BufferSize, j ); }
-    if( !Success )
-    {
-     if( EasyBMPwarnings )
-     {
-      cout << "EasyBMP Error: Could not read enough pixel data!" << endl;
-	 }
-	 j = -1;
+     if( !ReadRow( &Buffer[(size_t) k*BufferSize], BufferSize, Height-1-FirstRow-k ) )
+     { RowsDecoded = false; }
     }
-   }   
-   j--;
+    return RowsRead == Rows && RowsDecoded;
+   } );
+  if( !Success && EasyBMPwarnings )
+  {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
+   cout << "EasyBMP Error: Could not read proper amount of data." << endl;
   }
-  delete [] Buffer; 
  }
 
  if( BitDepth == 16 )
@@ -1015,6 +1114,7 @@ bool BMP::ReadFromFile( const char* FileName )
   {
    if( EasyBMPwarnings )
    {
+    std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
     cout << "EasyBMP Warning: Extra meta data detected in file " 
          << FileName << endl
          << "                 Data will be skipped." << endl;
@@ -1062,9 +1162,9 @@ bool BMP::ReadFromFile( const char* FileName )
     ebmpBYTE GreenBYTE = (ebmpBYTE) 8*(Green>>GreenShift);
     ebmpBYTE RedBYTE = (ebmpBYTE) 8*(Red>>RedShift);
 		
-	(Pixels[i][j]).Red = RedBYTE;
-	(Pixels[i][j]).Green = GreenBYTE;
-	(Pixels[i][j]).Blue = BlueBYTE;
+	GetRow(j)[i].Red = RedBYTE;
+	GetRow(j)[i].Green = GreenBYTE;
+	GetRow(j)[i].Blue = BlueBYTE;
 	
 	i++;
    }
@@ -1090,6 +1190,7 @@ bool BMP::CreateStandardColorTable( void )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Attempted to create color table at a bit" << endl
         << "                 depth that does not require a color table." << endl
     	<< "                 Ignoring request." << endl;
@@ -1303,6 +1404,7 @@ BMFH GetBMFH( const char* szFileNameIn )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Cannot initialize from file " 
         << szFileNameIn << "." << endl
         << "               File cannot be opened or does not exist." 
@@ -1339,6 +1441,7 @@ BMIH GetBMIH( const char* szFileNameIn )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Cannot initialize from file " 
         << szFileNameIn << "." << endl
         << "               File cannot be opened or does not exist." 
@@ -1388,6 +1491,7 @@ void DisplayBitmapInfo( const char* szFileNameIn )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: Cannot initialize from file " 
         << szFileNameIn << "." << endl
         << "               File cannot be opened or does not exist." 
@@ -1530,6 +1634,7 @@ bool CreateGrayscaleColorTable( BMP& InputImage )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Warning: Attempted to create color table at a bit" << endl
         << "                 depth that does not require a color table." << endl
    	    << "                 Ignoring request." << endl;
@@ -1558,23 +1663,84 @@ bool CreateGrayscaleColorTable( BMP& InputImage )
  return true;
 }
 
+bool BMP::ReadRow( ebmpBYTE* Buffer, int BufferSize, int Row )
+{
+ if( BitDepth == 1  )
+ { return Read1bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 4  )
+ { return Read4bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 8  )
+ { return Read8bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 24 )
+ { return Read24bitRow( Buffer, BufferSize, Row ); }
+ if( BitDepth == 32 )
+ { return Read32bitRow( Buffer, BufferSize, Row ); }
+ return false;
+}
+
+bool BMP::WriteRow( ebmpBYTE* Buffer, int BufferSize, int Row )
+{
+ if( BitDepth == 1  )
+ { return Write1bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 4  )
+ { return Write4bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 8  )
+ { return Write8bitRow(  Buffer, BufferSize, Row ); }
+ if( BitDepth == 24 )
+ { return Write24bitRow( Buffer, BufferSize, Row ); }
+ if( BitDepth == 32 )
+ { return Write32bitRow( Buffer, BufferSize, Row ); }
+ return false;
+}
+
+bool BMP::ReadRawRows( FILE* fp, int BytesToSkip, int RowWidth, int RowCount, BMPrawRowReader* RawReader )
+{
+ using namespace std;
+ if( !RawReader->SetSize( RowWidth, RowCount, BitDepth ) )
+ { return false; }
+ if( BytesToSkip > 0 )
+ {
+  if( EasyBMPwarnings )
+  {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
+   cout << "EasyBMP Warning: Extra meta data detected in file." << endl
+        << "                 Data will be skipped." << endl;
+  }
+  fseek( fp, BytesToSkip, SEEK_CUR );
+ }
+ 
+ int BufferSize = ( ( RowWidth*BitDepth + 31 ) / 32 ) * 4;
+ long long DataStart = ftell( fp );
+ bool Success = ForEachRowBand( RowCount, BufferSize, 
+  [&]( int FirstRow, int Rows, std::vector<ebmpBYTE>& Buffer )
+  {
+   Buffer.resize( (size_t) Rows*BufferSize );
+   int RowsRead = (int) ( ReadAt( fp, &Buffer[0], Buffer.size(), DataStart + (long long) FirstRow*BufferSize ) / BufferSize );
+   for( int k=0 ; k < RowsRead ; k++ )
+   { RawReader->ReadRow( &Buffer[(size_t) k*BufferSize], RowCount-1-FirstRow-k ); }
+   return RowsRead == Rows;
+  } );
+ if( !Success && EasyBMPwarnings )
+ {
+  std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
+  cout << "EasyBMP Error: Could not read proper amount of data." << endl;
+ }
+ return Success;
+}
+
 bool BMP::Read32bitRow( ebmpBYTE* Buffer, int BufferSize, int Row )
 { 
- int i;
  if( Width*4 > BufferSize )
  { return false; }
- for( i=0 ; i < Width ; i++ )
- { memcpy( (char*) &(Pixels[i][Row]), (char*) Buffer+4*i, 4 ); }
+ memcpy( (char*) GetRow(Row), (char*) Buffer, 4*Width );
  return true;
 }
 
 bool BMP::Read24bitRow( ebmpBYTE* Buffer, int BufferSize, int Row )
 { 
- int i;
  if( Width*3 > BufferSize )
  { return false; }
- for( i=0 ; i < Width ; i++ )
- { memcpy( (char*) &(Pixels[i][Row]), Buffer+3*i, 3 ); }
+ decodeBgrRow( Buffer, GetRow(Row), Width );
  return true;
 }
 
@@ -1641,11 +1807,9 @@ bool BMP::Read1bitRow(  ebmpBYTE* Buffer, int BufferSize, int Row )
 
 bool BMP::Write32bitRow( ebmpBYTE* Buffer, int BufferSize, int Row )
 { 
- int i;
  if( Width*4 > BufferSize )
  { return false; }
- for( i=0 ; i < Width ; i++ )
- { memcpy( (char*) Buffer+4*i, (char*) &(Pixels[i][Row]), 4 ); }
+ memcpy( (char*) Buffer, (char*) GetRow(Row), 4*Width );
  return true;
 }
 
@@ -1654,8 +1818,9 @@ bool BMP::Write24bitRow( ebmpBYTE* Buffer, int BufferSize, int Row )
  int i;
  if( Width*3 > BufferSize )
  { return false; }
+ RGBApixel* Input = GetRow(Row);
  for( i=0 ; i < Width ; i++ )
- { memcpy( (char*) Buffer+3*i,  (char*) &(Pixels[i][Row]), 3 ); }
+ { memcpy( (char*) Buffer+3*i,  (char*) (Input+i), 3 ); }
  return true;
 }
 
@@ -1665,7 +1830,7 @@ bool BMP::Write8bitRow(  ebmpBYTE* Buffer, int BufferSize, int Row )
  if( Width > BufferSize )
  { return false; }
  for( i=0 ; i < Width ; i++ )
- { Buffer[i] = FindClosestColor( Pixels[i][Row] ); }
+ { Buffer[i] = FindClosestColor( GetRow(Row)[i] ); }
  return true;
 }
 
@@ -1684,7 +1849,7 @@ bool BMP::Write4bitRow(  ebmpBYTE* Buffer, int BufferSize, int Row )
   int Index = 0;
   while( j < 2 && i < Width )
   {
-   Index += ( PositionWeights[j]* (int) FindClosestColor( Pixels[i][Row] ) ); 
+   Index += ( PositionWeights[j]* (int) FindClosestColor( GetRow(Row)[i] ) ); 
    i++; j++;   
   }
   Buffer[k] = (ebmpBYTE) Index;
@@ -1708,7 +1873,7 @@ bool BMP::Write1bitRow(  ebmpBYTE* Buffer, int BufferSize, int Row )
   int Index = 0;
   while( j < 8 && i < Width )
   {
-   Index += ( PositionWeights[j]* (int) FindClosestColor( Pixels[i][Row] ) ); 
+   Index += ( PositionWeights[j]* (int) FindClosestColor( GetRow(Row)[i] ) ); 
    i++; j++;   
   }
   Buffer[k] = (ebmpBYTE) Index;
@@ -1725,10 +1890,15 @@ ebmpBYTE BMP::FindClosestColor( RGBApixel& input )
  int NumberOfColors = TellNumberOfColors();
  ebmpBYTE BestI = 0;
  int BestMatch = 999999;
+ 
+ // called for every pixel of 1, 4 and 8 bit rows, possibly on several threads, 
+ // so the table is read directly instead of through the checks of GetColor
+ if( !Colors )
+ { return BestI; }
   
  while( i < NumberOfColors )
  {
-  RGBApixel Attempt = GetColor( i );
+  const RGBApixel& Attempt = Colors[i];
   int TempMatch = IntSquare( (int) Attempt.Red - (int) input.Red )
                 + IntSquare( (int) Attempt.Green - (int) input.Green )
                 + IntSquare( (int) Attempt.Blue - (int) input.Blue );
@@ -1749,6 +1919,7 @@ bool EasyBMPcheckDataSize( void )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: ebmpBYTE has the wrong size (" 
         << sizeof( ebmpBYTE ) << " bytes)," << endl
 	    << "               Compared to the expected 1 byte value" << endl;
@@ -1759,6 +1930,7 @@ bool EasyBMPcheckDataSize( void )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: ebmpWORD has the wrong size (" 
         << sizeof( ebmpWORD ) << " bytes)," << endl
 	    << "               Compared to the expected 2 byte value" << endl;
@@ -1769,6 +1941,7 @@ bool EasyBMPcheckDataSize( void )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    cout << "EasyBMP Error: ebmpDWORD has the wrong size (" 
         << sizeof( ebmpDWORD ) << " bytes)," << endl
 	    << "               Compared to the expected 4 byte value" << endl;
@@ -1792,6 +1965,7 @@ bool Rescale( BMP& InputImage , char mode, int NewDimension )
  {
   if( EasyBMPwarnings )
   {
+   std::lock_guard<std::mutex> Lock( EasyBMPoutputMutex );
    char ErrorMessage [1024];
    sprintf( ErrorMessage, "EasyBMP Error: Unknown rescale mode %c requested\n" , mode );
    cout << ErrorMessage; 
@@ -24,13 +24,24 @@
 bool SafeFread( char* buffer, int size, int number, FILE* fp );
 bool EasyBMPcheckDataSize( void );
 
+// receives the rows of 24 and 32 bit files instead of BMP, see BMP::ReadFromFile
+class BMPrawRowReader
+{public:
+ virtual ~BMPrawRowReader() {}
+ // called once before the rows, false stops reading
+ virtual bool SetSize( int Width, int Height, int BitDepth ) = 0;
+ // row as stored in the file: blue, green, red (and alpha for 32 bits) bytes per pixel,
+ // called from several threads at once for different rows
+ virtual void ReadRow( const ebmpBYTE* Buffer, int Row ) = 0;
+};
+
 class BMP
 {private:
 
  int BitDepth;
  int Width;
  int Height;
- RGBApixel** Pixels;
+ RGBApixel* Pixels; // one row-major buffer starting on a cache line, Width pixels per row
  RGBApixel* Colors;
  int XPelsPerMeter;
  int YPelsPerMeter;
@@ -53,6 +64,10 @@ class BMP
  bool Write1bitRow(  ebmpBYTE* Buffer, int BufferSize, int Row );
  
  ebmpBYTE FindClosestColor( RGBApixel& input );
+ 
+ bool ReadRow( ebmpBYTE* Buffer, int BufferSize, int Row );
+ bool WriteRow( ebmpBYTE* Buffer, int BufferSize, int Row );
+ bool ReadRawRows( FILE* fp, int BytesToSkip, int RowWidth, int RowCount, BMPrawRowReader* RawReader );
 
  public: 
 
@@ -72,12 +87,19 @@ class BMP
  RGBApixel GetPixel( int i, int j ) const;
  bool SetPixel( int i, int j, RGBApixel NewPixel );
  
+ // unchecked pointer to the Width pixels of row j
+ RGBApixel* GetRow( int j ) { return Pixels + (size_t) j * Width; }
+ const RGBApixel* GetRow( int j ) const { return Pixels + (size_t) j * Width; }
+ 
  bool CreateStandardColorTable( void );
  
  bool SetSize( int NewWidth, int NewHeight );
  bool SetBitDepth( int NewDepth );
  bool WriteToFile( const char* FileName );
  bool ReadFromFile( const char* FileName );
+ // 24 and 32 bit rows are passed undecoded to RawReader and the BMP is left 1 x 1, 
+ // other bit depths are read to the BMP as usual
+ bool ReadFromFile( const char* FileName, BMPrawRowReader* RawReader );
  
  RGBApixel GetColor( int ColorNumber );
  bool SetColor( int ColorNumber, RGBApixel NewColor ); 
@@ -0,0 +1,166 @@
+/*
+ * FusedPrewitt.cpp
+ *
+ *  Grayscale conversion, Prewitt operator and threshold in one pass over bitmap file rows.
+ */
+
+#include "FusedPrewitt.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#define FILE_HEADER_SIZE		14
+#define INFO_HEADER_SIZE		40
+#define PELS_PER_METER			3780
+
+namespace {
+
+uint32_t getLittleEndian(const unsigned char* bytes, int count)
+{
+	uint32_t value = 0;
+	for (int k = count - 1; k >= 0; --k)
+		value = (value << 8) | bytes[k];
+	return value;
+}
+
+void putLittleEndian(unsigned char* bytes, uint32_t value, int count)
+{
+	for (int k = 0; k < count; ++k)
+		bytes[k] = (unsigned char)(value >> (8 * k));
+}
+
+// bytes of one stored row, rows are padded to 4 bytes
+int bitmapRowSize(int width, int bitsPerPixel)
+{
+	return (width * bitsPerPixel + 31) / 32 * 4;
+}
+
+struct RawBitmap {
+	int width;
+	int height;
+	int bytesPerPixel;
+	uint32_t dataOffset;
+};
+
+bool readHeader(FILE* file, RawBitmap& bitmap)
+{
+	unsigned char header[FILE_HEADER_SIZE + INFO_HEADER_SIZE];
+	if (fread(header, 1, sizeof(header), file) != sizeof(header) || header[0] != 'B' || header[1] != 'M')
+		return false;
+
+	int32_t width = (int32_t)getLittleEndian(header + 18, 4);
+	int32_t height = (int32_t)getLittleEndian(header + 22, 4);
+	int bitsPerPixel = getLittleEndian(header + 28, 2);
+	uint32_t compression = getLittleEndian(header + 30, 4);
+	if (width <= 0 || height <= 0 || compression != 0 || (bitsPerPixel != 24 && bitsPerPixel != 32))
+		return false;
+
+	bitmap.width = width;
+	bitmap.height = height;
+	bitmap.bytesPerPixel = bitsPerPixel / 8;
+	bitmap.dataOffset = getLittleEndian(header + 10, 4);
+	return fseek(file, bitmap.dataOffset, SEEK_SET) == 0;
+}
+
+// 24 bit header as written by EasyBMP
+bool writeHeader(FILE* file, int width, int height)
+{
+	unsigned char header[FILE_HEADER_SIZE + INFO_HEADER_SIZE] = { 'B', 'M' };
+	uint32_t dataSize = (uint32_t)bitmapRowSize(width, 24) * height;
+	putLittleEndian(header + 2, FILE_HEADER_SIZE + INFO_HEADER_SIZE + dataSize, 4);
+	putLittleEndian(header + 10, FILE_HEADER_SIZE + INFO_HEADER_SIZE, 4);
+	putLittleEndian(header + 14, INFO_HEADER_SIZE, 4);
+	putLittleEndian(header + 18, width, 4);
+	putLittleEndian(header + 22, height, 4);
+	putLittleEndian(header + 26, 1, 2);
+	putLittleEndian(header + 28, 24, 2);
+	putLittleEndian(header + 34, dataSize, 4);
+	putLittleEndian(header + 38, PELS_PER_METER, 4);
+	putLittleEndian(header + 42, PELS_PER_METER, 4);
+	return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+// same conversion as BitmapRawConverter::putPixel, stored pixels are in blue, green, red order
+void luminanceRow(const unsigned char* raw, uint8_t* luminance, int width, int bytesPerPixel)
+{
+	for (int j = 0; j < width; ++j, raw += bytesPerPixel)
+		luminance[j] = (uint8_t)((30 * raw[2] + 59 * raw[1] + 11 * raw[0]) / 100);
+}
+
+}
+
+bool filter_fused_prewitt(const char* inFilename, const char* outFilename, const int* filterVer, const int* filterHor, int filterSize)
+{
+	FILE* in = fopen(inFilename, "rb");
+	if (in == NULL)
+		return false;
+	RawBitmap bitmap;
+	if (!readHeader(in, bitmap)) {
+		fclose(in);
+		return false;
+	}
+	FILE* out = fopen(outFilename, "wb");
+	if (out == NULL) {
+		fclose(in);
+		return false;
+	}
+
+	int width = bitmap.width, height = bitmap.height;
+	int offset = filterSize / 2;
+	int count = width - 2 * offset;
+	bool success = writeHeader(out, width, height);
+
+	std::vector<unsigned char> raw(bitmapRowSize(width, bitmap.bytesPerPixel * 8));
+	std::vector<unsigned char> outRow(bitmapRowSize(width, 24), 0);
+	std::vector<uint8_t> lines((size_t)filterSize * width);
+	std::vector<int> sumGy(std::max(count, 1)), sumGx(std::max(count, 1));
+
+	// rows are stored bottom up, stored row f is image row height - 1 - f, kernel rows are flipped accordingly
+	for (int f = 0; f < height && success; ++f) {
+		success = fread(&raw[0], 1, raw.size(), in) == raw.size();
+		if (!success)
+			break;
+		luminanceRow(&raw[0], &lines[(size_t)(f % filterSize) * width], width, bitmap.bytesPerPixel);
+
+		// border rows before the first full window
+		if (f < offset)
+			success = fwrite(&outRow[0], 1, outRow.size(), out) == outRow.size();
+		if (f < 2 * offset || !success)
+			continue;
+
+		int center = f - offset;
+		std::fill(sumGy.begin(), sumGy.end(), 0);
+		std::fill(sumGx.begin(), sumGx.end(), 0);
+		for (int ki = 0; ki < filterSize; ++ki) {
+			const uint8_t* line = &lines[(size_t)((center + offset - ki) % filterSize) * width];
+			for (int kj = 0; kj < filterSize; ++kj) {
+				int ver = filterVer[ki * filterSize + kj];
+				int hor = filterHor[ki * filterSize + kj];
+				const uint8_t* pixels = line + kj;
+				if (ver != 0)
+					for (int j = 0; j < count; ++j)
+						sumGy[j] += ver * pixels[j];
+				if (hor != 0)
+					for (int j = 0; j < count; ++j)
+						sumGx[j] += hor * pixels[j];
+			}
+		}
+
+		for (int j = 0; j < count; ++j) {
+			unsigned char* pixel = &outRow[3 * (offset + j)];
+			pixel[0] = pixel[1] = pixel[2] = abs(sumGy[j]) + abs(sumGx[j]) >= 128 ? 255 : 0;
+		}
+		success = fwrite(&outRow[0], 1, outRow.size(), out) == outRow.size();
+	}
+
+	// border rows after the last full window
+	std::fill(outRow.begin(), outRow.end(), 0);
+	for (int f = std::max(height - offset, offset); f < height && success; ++f)
+		success = fwrite(&outRow[0], 1, outRow.size(), out) == outRow.size();
+
+	fclose(in);
+	success = fclose(out) == 0 && success;
+	return success;
+}
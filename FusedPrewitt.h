@@ -0,0 +1,25 @@
+/*
+ * FusedPrewitt.h
+ *
+ *  Grayscale conversion, Prewitt operator and threshold in one pass over bitmap file rows.
+ */
+
+#ifndef FUSEDPREWITT_H_
+#define FUSEDPREWITT_H_
+
+/**
+* @brief Edge detection using Prewitt operator streamed from input to output bitmap file. Rows of an
+* uncompressed 24 or 32 bit bitmap are read one at a time, converted to luminance into a ring of filterSize
+* lines and the kernel and threshold are applied as soon as the ring is full, so output rows are written
+* without any full image buffer. Output is a 24 bit bitmap identical to the one written by
+* BitmapRawConverter after filter_serial_prewitt, border pixels are 0.
+* @param inFilename input bitmap file name
+* @param outFilename output bitmap file name
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @return false if file can not be read or written or its format is not supported
+*/
+bool filter_fused_prewitt(const char* inFilename, const char* outFilename, const int* filterVer, const int* filterHor, int filterSize);
+
+#endif /* FUSEDPREWITT_H_ */
@@ -0,0 +1,97 @@
+/*
+ * IntegralEdges.cpp
+ *
+ *  Edge detection for several lookup widths from one summed-area table of the threshold mask.
+ */
+
+#include "IntegralEdges.h"
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+// columns handled by one task of the vertical prefix pass
+#define COLUMN_GRAIN			1024
+
+template<typename InPixel>
+void MaskIntegralImage::build(const InPixel* inBuffer, int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	size_t stride = (size_t)width + 1;
+	sums.assign(stride * (height + 1), 0);
+	uint32_t* table = &sums[0];
+
+	// prefix sums along rows, row i of the image goes to table row i + 1
+	tbb::parallel_for(tbb::blocked_range<int>(0, height), [=](const tbb::blocked_range<int>& range) {
+		for (int i = range.begin(); i < range.end(); ++i) {
+			const InPixel* in = inBuffer + (size_t)i * width;
+			uint32_t* row = table + (i + 1) * stride;
+			uint32_t sum = 0;
+			for (int j = 0; j < width; ++j) {
+				sum += in[j] >= 128;
+				row[j + 1] = sum;
+			}
+		}
+	});
+
+	// prefix sums down the columns, column blocks are independent
+	tbb::parallel_for(tbb::blocked_range<int>(1, width + 1, COLUMN_GRAIN), [=](const tbb::blocked_range<int>& range) {
+		for (int i = 2; i <= height; ++i) {
+			uint32_t* row = table + i * stride;
+			const uint32_t* above = row - stride;
+			for (int j = range.begin(); j < range.end(); ++j)
+				row[j] += above[j];
+		}
+	});
+}
+
+template<typename OutPixel>
+void filter_edge_detection_sweep(const MaskIntegralImage& integral, const std::vector<int>& lookupWidths,
+	const std::vector<OutPixel*>& outBuffers)
+{
+	int width = integral.getWidth();
+	int height = integral.getHeight();
+	size_t stride = (size_t)width + 1;
+	const uint32_t* table = integral.table();
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& range) {
+		for (int i = range.begin(); i < range.end(); ++i) {
+			for (size_t k = 0; k < lookupWidths.size(); ++k) {
+				int lookupWidth = lookupWidths[k];
+				int offset = lookupWidth / 2;
+				if (i < offset || i >= height - offset)
+					continue;
+
+				// window starts offset rows and columns before the pixel, so for even widths it reaches offset - 1 past it
+				uint32_t full = (uint32_t)lookupWidth * lookupWidth;
+				const uint32_t* top = table + (i - offset) * stride;
+				const uint32_t* bottom = table + (i - offset + lookupWidth) * stride;
+				OutPixel* outRow = outBuffers[k] + (size_t)i * width;
+				for (int j = offset; j < width - offset; ++j) {
+					int left = j - offset, right = j - offset + lookupWidth;
+					uint32_t count = bottom[right] - top[right] - bottom[left] + top[left];
+					outRow[j] = count != 0 && count != full ? 255 : 0;
+				}
+			}
+		}
+	});
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_edge_detection_sweep(const InPixel* inBuffer, int width, int height, const std::vector<int>& lookupWidths,
+	const std::vector<OutPixel*>& outBuffers)
+{
+	MaskIntegralImage integral;
+	integral.build(inBuffer, width, height);
+	filter_edge_detection_sweep(integral, lookupWidths, outBuffers);
+}
+
+template void MaskIntegralImage::build<uint8_t>(const uint8_t* inBuffer, int width, int height);
+template void MaskIntegralImage::build<int>(const int* inBuffer, int width, int height);
+template void filter_edge_detection_sweep<uint8_t>(const MaskIntegralImage& integral, const std::vector<int>& lookupWidths,
+	const std::vector<uint8_t*>& outBuffers);
+template void filter_edge_detection_sweep<int>(const MaskIntegralImage& integral, const std::vector<int>& lookupWidths,
+	const std::vector<int*>& outBuffers);
+template void filter_edge_detection_sweep<uint8_t, uint8_t>(const uint8_t* inBuffer, int width, int height,
+	const std::vector<int>& lookupWidths, const std::vector<uint8_t*>& outBuffers);
+template void filter_edge_detection_sweep<int, int>(const int* inBuffer, int width, int height,
+	const std::vector<int>& lookupWidths, const std::vector<int*>& outBuffers);
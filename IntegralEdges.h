@@ -0,0 +1,72 @@
+/*
+ * IntegralEdges.h
+ *
+ *  Edge detection for several lookup widths from one summed-area table of the threshold mask.
+ */
+
+#ifndef INTEGRALEDGES_H_
+#define INTEGRALEDGES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+* @brief Summed-area table of pixels >= 128. Sums are kept modulo 2^32, which keeps every rectangle
+* count exact as long as the rectangle itself has less than 2^32 pixels.
+*/
+class MaskIntegralImage {
+private:
+	int width;
+	int height;
+	std::vector<uint32_t> sums;
+public:
+	/**
+	* @brief Builds the table in parallel, rows are prefix summed first and then columns
+	* @param inBuffer buffer of input image
+	* @param width image width
+	* @param height image height
+	*/
+	template<typename InPixel>
+	void build(const InPixel* inBuffer, int width, int height);
+
+	/**
+	* @brief Number of pixels >= 128 in rows rowStart .. rowEnd - 1 and columns columnStart .. columnEnd - 1
+	*/
+	uint32_t count(int rowStart, int columnStart, int rowEnd, int columnEnd) const
+	{
+		size_t stride = (size_t)width + 1;
+		return sums[rowEnd * stride + columnEnd] - sums[rowStart * stride + columnEnd]
+			- sums[rowEnd * stride + columnStart] + sums[rowStart * stride + columnStart];
+	}
+
+	// sums[i * (width + 1) + j] is the count of rows 0 .. i - 1 and columns 0 .. j - 1
+	const uint32_t* table() const { return &sums[0]; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+};
+
+/**
+* @brief Edge detection algorithm for several lookup widths at once. Threshold mask is integrated once,
+* every window is then a rectangle query: pixel is part of the edge if the window has at least one, but
+* not all pixels >= 128. Window of pixel (i, j) starts at (i - lookupWidth / 2, j - lookupWidth / 2) for odd
+* and even widths. All edge maps are written in one parallel sweep over the rows. Each result is identical
+* to filter_serial_edge_detection with that lookup width. Instantiated for uint8_t and int pixels.
+* @param inBuffer buffer of input image
+* @param width image width
+* @param height image height
+* @param lookupWidths sizes of neighbour lookup matrix
+* @param outBuffers output image buffer for every lookup width
+*/
+template<typename InPixel, typename OutPixel>
+void filter_edge_detection_sweep(const InPixel* inBuffer, int width, int height, const std::vector<int>& lookupWidths,
+	const std::vector<OutPixel*>& outBuffers);
+
+/**
+* @brief Same as filter_edge_detection_sweep, for an already built table
+*/
+template<typename OutPixel>
+void filter_edge_detection_sweep(const MaskIntegralImage& integral, const std::vector<int>& lookupWidths,
+	const std::vector<OutPixel*>& outBuffers);
+
+#endif /* INTEGRALEDGES_H_ */
@@ -0,0 +1,245 @@
+/*
+ * MappedBitmap.cpp
+ *
+ *  Uncompressed 24 and 32 bit bitmap files mapped to memory, rows are read and written in place.
+ */
+
+#include "MappedBitmap.h"
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// file header and BITMAPINFOHEADER
+#define FILE_HEADER_BYTES		14
+#define INFO_HEADER_BYTES		40
+// same resolution EasyBMP writes, 96 dpi
+#define PELS_PER_METER			3780
+
+namespace {
+
+// headers are little endian whatever the byte order of the machine
+uint32_t readLittle(const uint8_t* bytes, int count)
+{
+	uint32_t value = 0;
+	for (int k = count - 1; k >= 0; --k)
+		value = value << 8 | bytes[k];
+	return value;
+}
+
+void writeLittle(uint8_t* bytes, uint32_t value, int count)
+{
+	for (int k = 0; k < count; ++k)
+		bytes[k] = (uint8_t)(value >> 8 * k);
+}
+
+// padded to 4 bytes
+size_t rowSize(int width, int bitDepth)
+{
+	return ((size_t)width * bitDepth + 31) / 32 * 4;
+}
+
+}
+
+MappedFile::MappedFile() : bytes(nullptr), length(0)
+#ifdef _WIN32
+	, file(INVALID_HANDLE_VALUE), mapping(NULL)
+#else
+	, file(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::openRead(const char* filename)
+{
+	close();
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0
+		|| (unsigned long long)fileSize.QuadPart > (size_t)-1) {
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL)
+		bytes = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (bytes == nullptr) {
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+bool MappedFile::create(const char* filename, size_t size)
+{
+	close();
+	file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = (LONGLONG)size;
+	if (file == INVALID_HANDLE_VALUE || !SetFilePointerEx(file, fileSize, NULL, FILE_BEGIN) || !SetEndOfFile(file)) {
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+	if (mapping != NULL)
+		bytes = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+	if (bytes == nullptr) {
+		close();
+		return false;
+	}
+	length = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes != nullptr)
+		UnmapViewOfFile(bytes);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	bytes = nullptr;
+	length = 0;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::openRead(const char* filename)
+{
+	close();
+	file = ::open(filename, O_RDONLY);
+	struct stat status;
+	if (file < 0 || fstat(file, &status) != 0 || status.st_size == 0 || (unsigned long long)status.st_size > (size_t)-1) {
+		close();
+		return false;
+	}
+	void* address = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, file, 0);
+	if (address == MAP_FAILED) {
+		close();
+		return false;
+	}
+	bytes = (uint8_t*)address;
+	length = (size_t)status.st_size;
+	// rows are decoded front to back, let the kernel read ahead
+	madvise(address, length, MADV_SEQUENTIAL);
+	return true;
+}
+
+bool MappedFile::create(const char* filename, size_t size)
+{
+	close();
+	// existing file is resized rather than truncated, truncating makes file systems drop or flush its cached pages
+	file = ::open(filename, O_RDWR | O_CREAT, 0644);
+	if (file < 0 || ftruncate(file, (off_t)size) != 0) {
+		close();
+		return false;
+	}
+	void* address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (address == MAP_FAILED) {
+		close();
+		return false;
+	}
+	bytes = (uint8_t*)address;
+	length = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes != nullptr)
+		munmap(bytes, length);
+	if (file >= 0)
+		::close(file);
+	bytes = nullptr;
+	length = 0;
+	file = -1;
+}
+
+#endif
+
+bool MappedBitmapReader::open(const char* filename)
+{
+	if (!file.openRead(filename) || file.size() < FILE_HEADER_BYTES + INFO_HEADER_BYTES) {
+		file.close();
+		return false;
+	}
+
+	const uint8_t* header = file.data();
+	uint32_t pixelOffset = readLittle(header + 10, 4);
+	uint32_t infoSize = readLittle(header + 14, 4);
+	int fileWidth = (int)readLittle(header + 18, 4);
+	int fileHeight = (int)readLittle(header + 22, 4);
+	int planes = (int)readLittle(header + 26, 2);
+	int depth = (int)readLittle(header + 28, 2);
+	uint32_t compression = readLittle(header + 30, 4);
+
+	bool topDown = fileHeight < 0;
+	int rows = topDown ? -fileHeight : fileHeight;
+	if (header[0] != 'B' || header[1] != 'M' || infoSize < INFO_HEADER_BYTES || planes != 1 || (depth != 24 && depth != 32)
+		|| compression != 0 || fileWidth <= 0 || rows <= 0 || pixelOffset > file.size()
+		|| (file.size() - pixelOffset) / rowSize(fileWidth, depth) < (size_t)rows) {
+		file.close();
+		return false;
+	}
+
+	width = fileWidth;
+	height = rows;
+	bitDepth = depth;
+	stride = (ptrdiff_t)rowSize(width, bitDepth);
+	firstRow = file.data() + pixelOffset;
+	if (!topDown) {
+		firstRow += (height - 1) * stride;
+		stride = -stride;
+	}
+	return true;
+}
+
+bool MappedBitmapWriter::create(const char* filename, int width, int height, int bitDepth)
+{
+	this->height = height;
+	rowBytes = rowSize(width, bitDepth);
+	size_t pixelBytes = rowBytes * height;
+	if (!file.create(filename, FILE_HEADER_BYTES + INFO_HEADER_BYTES + pixelBytes))
+		return false;
+
+	uint8_t* header = file.data();
+	header[0] = 'B';
+	header[1] = 'M';
+	writeLittle(header + 2, (uint32_t)file.size(), 4);
+	writeLittle(header + 6, 0, 4);
+	writeLittle(header + 10, FILE_HEADER_BYTES + INFO_HEADER_BYTES, 4);
+	writeLittle(header + 14, INFO_HEADER_BYTES, 4);
+	writeLittle(header + 18, width, 4);
+	writeLittle(header + 22, height, 4);
+	writeLittle(header + 26, 1, 2);
+	writeLittle(header + 28, bitDepth, 2);
+	writeLittle(header + 30, 0, 4);
+	writeLittle(header + 34, (uint32_t)pixelBytes, 4);
+	writeLittle(header + 38, PELS_PER_METER, 4);
+	writeLittle(header + 42, PELS_PER_METER, 4);
+	writeLittle(header + 46, 0, 4);
+	writeLittle(header + 50, 0, 4);
+	pixelArray = header + FILE_HEADER_BYTES + INFO_HEADER_BYTES;
+
+	// row bytes are written by the caller, padding is cleared here
+	size_t dataBytes = ((size_t)width * bitDepth + 7) / 8;
+	for (int j = 0; j < height; ++j)
+		memset(pixelArray + j * rowBytes + dataBytes, 0, rowBytes - dataBytes);
+	return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * MappedBitmap.h
+ *
+ *  Uncompressed 24 and 32 bit bitmap files mapped to memory, rows are read and written in place.
+ */
+
+#ifndef MAPPEDBITMAP_H_
+#define MAPPEDBITMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+* @brief Whole file mapped to memory, mmap on POSIX systems and file mapping on Windows
+*/
+class MappedFile {
+private:
+	uint8_t* bytes;
+	size_t length;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+public:
+	MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	/**
+	* @brief Maps existing file for reading
+	* @return false if file can not be opened or mapped, or is empty
+	*/
+	bool openRead(const char* filename);
+
+	/**
+	* @brief Creates file or resizes existing one and maps it for writing. Bytes of an existing file are kept,
+	* so the caller has to write all of them.
+	* @return false if file can not be created, resized or mapped
+	*/
+	bool create(const char* filename, size_t size);
+
+	/**
+	* @brief Unmaps and closes file, changes of created file are written by the page cache
+	*/
+	void close();
+
+	uint8_t* data() const { return bytes; }
+	size_t size() const { return length; }
+};
+
+/**
+* @brief Read only view of pixel array of mapped bitmap file. Rows are addressed from the top of the image
+* whether the file stores them bottom-up (positive height) or top-down (negative height).
+*/
+class MappedBitmapReader {
+private:
+	MappedFile file;
+	int width;
+	int height;
+	int bitDepth;
+	const uint8_t* firstRow;		// top row of the image
+	ptrdiff_t stride;				// bytes from a row to the one below it, negative for bottom-up files
+public:
+	MappedBitmapReader() : width(0), height(0), bitDepth(0), firstRow(nullptr), stride(0) {};
+
+	/**
+	* @brief Maps file and checks headers
+	* @return false if file can not be mapped or is not an uncompressed 24 or 32 bit bitmap,
+	* such files have to be read with EasyBMP
+	*/
+	bool open(const char* filename);
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getBitDepth() const { return bitDepth; }
+
+	/**
+	* @brief Row as stored in the file, blue, green, red (and alpha for 32 bit) bytes per pixel
+	* @param row image row, 0 is the top
+	*/
+	const uint8_t* getRow(int row) const { return firstRow + row * stride; }
+};
+
+/**
+* @brief Bitmap file created with its final size and mapped, headers are written by create and rows are
+* filled in place. Headers are the same EasyBMP writes.
+*/
+class MappedBitmapWriter {
+private:
+	MappedFile file;
+	int height;
+	size_t rowBytes;
+	uint8_t* pixelArray;
+public:
+	MappedBitmapWriter() : height(0), rowBytes(0), pixelArray(nullptr) {};
+
+	/**
+	* @brief Creates bottom-up file and writes headers and zero padding of rows, all pixels have to be written
+	* @param bitDepth 24 or 32
+	* @return false if file can not be created and mapped
+	*/
+	bool create(const char* filename, int width, int height, int bitDepth);
+
+	/**
+	* @brief Row to fill, blue, green, red (and alpha for 32 bit) bytes per pixel
+	* @param row image row, 0 is the top
+	*/
+	uint8_t* getRow(int row) const { return pixelArray + (size_t)(height - 1 - row) * rowBytes; }
+
+	/**
+	* @brief Unmaps and closes file
+	*/
+	void close() { file.close(); }
+};
+
+#endif /* MAPPEDBITMAP_H_ */
@@ -0,0 +1,171 @@
+/*
+ * PaddedImage.cpp
+ *
+ *  Pitched image buffer with halo rows and columns filled by border mode.
+ */
+
+#include "PaddedImage.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#define PITCH_ALIGNMENT			64
+
+namespace {
+
+// index inside 0 .. size - 1 that pixel x outside of the image is taken from
+int borderIndex(int x, int size, BorderMode mode)
+{
+	if (mode == BORDER_CLAMP)
+		return std::min(std::max(x, 0), size - 1);
+	if (size == 1)
+		return 0;
+	int period = 2 * (size - 1);
+	x = ((x % period) + period) % period;
+	return x < size ? x : period - x;
+}
+
+}
+
+const char* borderModeName(BorderMode mode)
+{
+	switch (mode) {
+	case BORDER_ZERO:
+		return "zero";
+	case BORDER_CLAMP:
+		return "clamp";
+	case BORDER_REFLECT:
+		return "reflect";
+	default:
+		return "none";
+	}
+}
+
+template<typename Pixel>
+void PaddedImage<Pixel>::assign(const Pixel* inBuffer, int width, int height, int halo, BorderMode mode)
+{
+	int alignment = PITCH_ALIGNMENT / sizeof(Pixel);
+	this->width = width;
+	this->height = height;
+	this->halo = halo;
+	pitch = (width + 2 * halo + alignment - 1) / alignment * alignment;
+	storage.assign((size_t)pitch * (height + 2 * halo), 0);
+
+	bool zero = mode != BORDER_CLAMP && mode != BORDER_REFLECT;
+	for (int i = -halo; i < height + halo; ++i) {
+		bool inside = i >= 0 && i < height;
+		if (zero && !inside)
+			continue;
+		Pixel* line = row(i);
+		memcpy(line, inBuffer + (size_t)(inside ? i : borderIndex(i, height, mode)) * width, width * sizeof(Pixel));
+		if (zero)
+			continue;
+		for (int j = 1; j <= halo; ++j) {
+			line[-j] = line[borderIndex(-j, width, mode)];
+			line[width - 1 + j] = line[borderIndex(width - 1 + j, width, mode)];
+		}
+	}
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_padded_prewitt(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd)
+{
+	int width = inImage.getWidth();
+	int offset = filterSize / 2;
+	int count = columnEnd - columnStart;
+	if (count <= 0)
+		return;
+	std::vector<int> sumGy(count), sumGx(count);
+
+	for (int i = rowStart; i < rowEnd; ++i) {
+		std::fill(sumGy.begin(), sumGy.end(), 0);
+		std::fill(sumGx.begin(), sumGx.end(), 0);
+		for (int ki = 0; ki < filterSize; ++ki) {
+			const InPixel* inRow = inImage.row(i - offset + ki) + columnStart - offset;
+			for (int kj = 0; kj < filterSize; ++kj) {
+				int ver = filterVer[ki * filterSize + kj];
+				int hor = filterHor[ki * filterSize + kj];
+				const InPixel* in = inRow + kj;
+				if (ver != 0)
+					for (int j = 0; j < count; ++j)
+						sumGy[j] += ver * in[j];
+				if (hor != 0)
+					for (int j = 0; j < count; ++j)
+						sumGx[j] += hor * in[j];
+			}
+		}
+
+		OutPixel* outRow = outBuffer + (size_t)i * width + columnStart;
+		for (int j = 0; j < count; ++j)
+			outRow[j] = std::abs(sumGy[j]) + std::abs(sumGx[j]) >= 128 ? 255 : 0;
+	}
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_padded_edge_detection(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, int lookupWidth, int rowStart, int rowEnd,
+	int columnStart, int columnEnd)
+{
+	int width = inImage.getWidth();
+	int offset = lookupWidth / 2;
+	int count = columnEnd - columnStart;
+	if (count <= 0)
+		return;
+	int lineWidth = count + 2 * offset;
+	std::vector<InPixel> columnMax(lineWidth), columnMin(lineWidth);
+
+	for (int i = rowStart; i < rowEnd; ++i) {
+		const InPixel* first = inImage.row(i - offset) + columnStart - offset;
+		std::copy(first, first + lineWidth, columnMax.begin());
+		std::copy(first, first + lineWidth, columnMin.begin());
+		for (int k = 1; k < lookupWidth; ++k) {
+			const InPixel* in = inImage.row(i - offset + k) + columnStart - offset;
+			for (int j = 0; j < lineWidth; ++j) {
+				columnMax[j] = std::max(columnMax[j], in[j]);
+				columnMin[j] = std::min(columnMin[j], in[j]);
+			}
+		}
+
+		OutPixel* outRow = outBuffer + (size_t)i * width + columnStart;
+		for (int j = 0; j < count; ++j) {
+			InPixel windowMax = columnMax[j], windowMin = columnMin[j];
+			for (int k = 1; k < lookupWidth; ++k) {
+				windowMax = std::max(windowMax, columnMax[j + k]);
+				windowMin = std::min(windowMin, columnMin[j + k]);
+			}
+			outRow[j] = windowMax >= 128 && windowMin < 128 ? 255 : 0;
+		}
+	}
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_padded_prewitt(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd)
+{
+	filter_padded_prewitt(inImage, outBuffer, filterVer, filterHor, filterSize, rowStart, rowEnd, 0, inImage.getWidth());
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_padded_edge_detection(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, int lookupWidth, int rowStart, int rowEnd)
+{
+	filter_padded_edge_detection(inImage, outBuffer, lookupWidth, rowStart, rowEnd, 0, inImage.getWidth());
+}
+
+template class PaddedImage<uint8_t>;
+template class PaddedImage<int>;
+template void filter_padded_prewitt<uint8_t, uint8_t>(const PaddedImage<uint8_t>& inImage, uint8_t* outBuffer, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_padded_prewitt<int, int>(const PaddedImage<int>& inImage, int* outBuffer, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_padded_edge_detection<uint8_t, uint8_t>(const PaddedImage<uint8_t>& inImage, uint8_t* outBuffer, int lookupWidth,
+	int rowStart, int rowEnd);
+template void filter_padded_edge_detection<int, int>(const PaddedImage<int>& inImage, int* outBuffer, int lookupWidth,
+	int rowStart, int rowEnd);
+template void filter_padded_prewitt<uint8_t, uint8_t>(const PaddedImage<uint8_t>& inImage, uint8_t* outBuffer, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_padded_prewitt<int, int>(const PaddedImage<int>& inImage, int* outBuffer, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_padded_edge_detection<uint8_t, uint8_t>(const PaddedImage<uint8_t>& inImage, uint8_t* outBuffer, int lookupWidth,
+	int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_padded_edge_detection<int, int>(const PaddedImage<int>& inImage, int* outBuffer, int lookupWidth,
+	int rowStart, int rowEnd, int columnStart, int columnEnd);
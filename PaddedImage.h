@@ -0,0 +1,106 @@
+/*
+ * PaddedImage.h
+ *
+ *  Pitched image buffer with halo rows and columns filled by border mode.
+ */
+
+#ifndef PADDEDIMAGE_H_
+#define PADDEDIMAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// how pixels outside of the image are defined
+enum BorderMode {
+	BORDER_NONE,		// border pixels are not processed and stay 0
+	BORDER_ZERO,		// pixels outside are 0
+	BORDER_CLAMP,		// pixels outside repeat the nearest image pixel
+	BORDER_REFLECT		// image is mirrored around border pixel (dcb|abcd|cba)
+};
+
+/**
+* @brief Name of border mode for printing
+*/
+const char* borderModeName(BorderMode mode);
+
+/**
+* @brief Image surrounded by halo pixels on every side, rows are pitch elements apart (pitch is rounded
+* up to 64 bytes). Pixel (i, j) is defined for i in -halo .. height + halo - 1 and j in -halo .. width + halo - 1,
+* so kernels not bigger than 2 * halo + 1 can be applied to every image pixel without bounds checks.
+*/
+template<typename Pixel>
+class PaddedImage {
+private:
+	int width;
+	int height;
+	int halo;
+	int pitch;
+	std::vector<Pixel> storage;
+public:
+	PaddedImage() : width(0), height(0), halo(0), pitch(0) {}
+
+	/**
+	* @brief Copies image into the buffer and fills halo according to border mode
+	* @param inBuffer buffer of input image
+	* @param width image width
+	* @param height image height
+	* @param halo number of pixels added on every side
+	* @param mode border mode, BORDER_NONE is filled as BORDER_ZERO
+	*/
+	void assign(const Pixel* inBuffer, int width, int height, int halo, BorderMode mode);
+
+	// pointer to pixel (i, 0)
+	Pixel* row(int i) { return &storage[(size_t)(i + halo) * pitch + halo]; }
+	const Pixel* row(int i) const { return &storage[(size_t)(i + halo) * pitch + halo]; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getHalo() const { return halo; }
+	int getPitch() const { return pitch; }
+};
+
+/**
+* @brief Prewitt operator on padded image, every pixel of rows rowStart .. rowEnd - 1 is computed including
+* image border. Kernel is applied row by row to whole lines without branches. Halo has to be at least
+* filterSize / 2. Instantiated for uint8_t and int pixels.
+* @param inImage padded input image
+* @param outBuffer buffer of output image
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_padded_prewitt(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd);
+
+/**
+* @brief Edge detection algorithm on padded image, every pixel of rows rowStart .. rowEnd - 1 is computed
+* including image border. Window minimum and maximum are reduced vertically over lines and then horizontally.
+* Halo has to be at least lookupWidth / 2. Instantiated for uint8_t and int pixels.
+* @param inImage padded input image
+* @param outBuffer buffer of output image
+* @param lookupWidth size of neighbour lookup matrix
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_padded_edge_detection(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, int lookupWidth, int rowStart, int rowEnd);
+
+/**
+* @brief Same as filter_padded_prewitt, limited to output columns columnStart .. columnEnd - 1
+*/
+template<typename InPixel, typename OutPixel>
+void filter_padded_prewitt(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+
+/**
+* @brief Same as filter_padded_edge_detection, limited to output columns columnStart .. columnEnd - 1
+*/
+template<typename InPixel, typename OutPixel>
+void filter_padded_edge_detection(const PaddedImage<InPixel>& inImage, OutPixel* outBuffer, int lookupWidth, int rowStart, int rowEnd,
+	int columnStart, int columnEnd);
+
+#endif /* PADDEDIMAGE_H_ */
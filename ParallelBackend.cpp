@@ -0,0 +1,250 @@
+/*
+ * ParallelBackend.cpp
+ *
+ *  Parallel loop over row ranges with runtime selectable threading library.
+ */
+
+#include "ParallelBackend.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/task_arena.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define RANGES_PER_THREAD		4
+
+namespace {
+
+typedef std::pair<int, int> RowRange;
+
+/**
+* @brief Fixed set of std::thread workers. Every worker owns a deque of row ranges, takes ranges from the
+* front of its own deque and, when that is empty, steals from the back of the others. Calling thread
+* works as worker 0, so one loop runs at a time.
+*/
+class ThreadPool {
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<RowRange> ranges;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<Queue> > queues;
+	std::mutex jobMutex;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(int, int)>* body;
+	std::atomic<int> remaining;
+	int generation;
+	bool stopping;
+
+	static thread_local bool insideWorker;
+
+	bool pop(int self, RowRange& range)
+	{
+		{
+			Queue& own = *queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.ranges.empty()) {
+				range = own.ranges.front();
+				own.ranges.pop_front();
+				return true;
+			}
+		}
+		for (size_t k = 1; k < queues.size(); ++k) {
+			Queue& victim = *queues[(self + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.ranges.empty()) {
+				range = victim.ranges.back();
+				victim.ranges.pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void work(int self)
+	{
+		RowRange range;
+		while (pop(self, range)) {
+			(*body)(range.first, range.second);
+			if (--remaining == 0) {
+				std::lock_guard<std::mutex> lock(wakeMutex);
+				done.notify_all();
+			}
+		}
+	}
+
+	void workerLoop(int self)
+	{
+		insideWorker = true;
+		int seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(wakeMutex);
+				wake.wait(lock, [&]() { return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+			}
+			work(self);
+		}
+	}
+
+public:
+	explicit ThreadPool(int threads) : body(nullptr), remaining(0), generation(0), stopping(false)
+	{
+		for (int k = 0; k < threads; ++k)
+			queues.push_back(std::unique_ptr<Queue>(new Queue()));
+		for (int k = 1; k < threads; ++k)
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this, k));
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t k = 0; k < workers.size(); ++k)
+			workers[k].join();
+	}
+
+	int threads() const { return (int)queues.size(); }
+
+	void run(const std::vector<RowRange>& ranges, const std::function<void(int, int)>& function)
+	{
+		if (insideWorker) {
+			for (size_t k = 0; k < ranges.size(); ++k)
+				function(ranges[k].first, ranges[k].second);
+			return;
+		}
+
+		std::lock_guard<std::mutex> job(jobMutex);
+		body = &function;
+		remaining = (int)ranges.size();
+		for (size_t k = 0; k < ranges.size(); ++k) {
+			Queue& queue = *queues[k % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.ranges.push_back(ranges[k]);
+		}
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			++generation;
+		}
+		wake.notify_all();
+
+		insideWorker = true;
+		work(0);
+		insideWorker = false;
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		done.wait(lock, [&]() { return remaining == 0; });
+	}
+};
+
+thread_local bool ThreadPool::insideWorker = false;
+
+ThreadPool& threadPool()
+{
+	static ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+	return pool;
+}
+
+std::vector<RowRange> splitRows(int begin, int end, int grain)
+{
+	std::vector<RowRange> ranges;
+	for (int start = begin; start < end; start += grain)
+		ranges.push_back(RowRange(start, std::min(start + grain, end)));
+	return ranges;
+}
+
+}
+
+const char* parallelBackendName(ParallelBackend backend)
+{
+	switch (backend) {
+	case BACKEND_TBB:
+		return "tbb";
+	case BACKEND_OPENMP:
+		return "openmp";
+	case BACKEND_THREAD_POOL:
+		return "thread pool";
+	default:
+		return "serial";
+	}
+}
+
+bool parallelBackendAvailable(ParallelBackend backend)
+{
+#ifdef _OPENMP
+	(void)backend;
+	return true;
+#else
+	return backend != BACKEND_OPENMP;
+#endif
+}
+
+int parallelBackendThreads(ParallelBackend backend)
+{
+	if (!parallelBackendAvailable(backend))
+		backend = BACKEND_TBB;
+	switch (backend) {
+	case BACKEND_TBB:
+		return tbb::this_task_arena::max_concurrency();
+#ifdef _OPENMP
+	case BACKEND_OPENMP:
+		return omp_get_max_threads();
+#endif
+	case BACKEND_THREAD_POOL:
+		return threadPool().threads();
+	default:
+		return 1;
+	}
+}
+
+void parallelRows(ParallelBackend backend, int begin, int end, int grain, const std::function<void(int, int)>& body)
+{
+	if (begin >= end)
+		return;
+	if (!parallelBackendAvailable(backend))
+		backend = BACKEND_TBB;
+	if (grain <= 0)
+		grain = std::max(1, (end - begin) / (parallelBackendThreads(backend) * RANGES_PER_THREAD));
+
+	switch (backend) {
+	case BACKEND_TBB:
+		tbb::parallel_for(tbb::blocked_range<int>(begin, end, grain), [&](const tbb::blocked_range<int>& range) {
+			body(range.begin(), range.end());
+		}, tbb::simple_partitioner());
+		break;
+#ifdef _OPENMP
+	case BACKEND_OPENMP: {
+		std::vector<RowRange> ranges = splitRows(begin, end, grain);
+		int count = (int)ranges.size();
+#pragma omp parallel for schedule(dynamic)
+		for (int k = 0; k < count; ++k)
+			body(ranges[k].first, ranges[k].second);
+		break;
+	}
+#endif
+	case BACKEND_THREAD_POOL:
+		threadPool().run(splitRows(begin, end, grain), body);
+		break;
+	default:
+		body(begin, end);
+		break;
+	}
+}
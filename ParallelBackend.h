@@ -0,0 +1,49 @@
+/*
+ * ParallelBackend.h
+ *
+ *  Parallel loop over row ranges with runtime selectable threading library.
+ */
+
+#ifndef PARALLELBACKEND_H_
+#define PARALLELBACKEND_H_
+
+#include <functional>
+
+/**
+* @brief Threading libraries parallelRows can run on
+*/
+enum ParallelBackend {
+	BACKEND_TBB,			// tbb::parallel_for
+	BACKEND_OPENMP,			// OpenMP dynamic schedule, only if compiled with OpenMP
+	BACKEND_THREAD_POOL,	// std::thread pool with per thread deques and work stealing
+	BACKEND_SERIAL			// calling thread only
+};
+
+/**
+* @brief Printable name of backend
+*/
+const char* parallelBackendName(ParallelBackend backend);
+
+/**
+* @brief Is backend compiled in
+*/
+bool parallelBackendAvailable(ParallelBackend backend);
+
+/**
+* @brief Number of threads backend runs on
+*/
+int parallelBackendThreads(ParallelBackend backend);
+
+/**
+* @brief Calls body for disjoint ranges [rangeStart, rangeEnd) covering begin .. end - 1, in parallel on given backend.
+* Ranges have at most grain rows, if grain is not positive there are about 4 ranges per thread. Calls from inside
+* a thread pool task run serially.
+* @param backend threading library, not available one falls back to BACKEND_TBB
+* @param begin first row
+* @param end row after the last row
+* @param grain maximum rows in one range
+* @param body function called with rangeStart and rangeEnd
+*/
+void parallelRows(ParallelBackend backend, int begin, int end, int grain, const std::function<void(int, int)>& body);
+
+#endif /* PARALLELBACKEND_H_ */
@@ -0,0 +1,180 @@
+/*
+ * PerfCounters.cpp
+ *
+ *  Hardware performance counters of all threads of the process, read through Linux perf_event_open.
+ */
+
+#include "PerfCounters.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#ifdef __linux__
+#include <dirent.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace {
+
+const char* const eventNames[] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branches", "branch_misses", "task_clock" };
+
+#ifdef __linux__
+
+struct EventConfig {
+	uint32_t type;
+	uint64_t config;
+};
+
+const EventConfig eventConfigs[] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK }
+};
+
+int openCounter(const EventConfig& event, int thread)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = event.type;
+	attr.config = event.config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(__NR_perf_event_open, &attr, thread, -1, -1, 0);
+}
+
+std::vector<int> processThreads()
+{
+	std::vector<int> threads;
+	DIR* directory = opendir("/proc/self/task");
+	if (directory == NULL)
+		return threads;
+	while (dirent* entry = readdir(directory))
+		if (entry->d_name[0] != '.')
+			threads.push_back(atoi(entry->d_name));
+	closedir(directory);
+	return threads;
+}
+
+#endif
+
+}
+
+const char* perfEventName(PerfEvent event)
+{
+	return eventNames[event];
+}
+
+PerfCounts emptyPerfCounts()
+{
+	PerfCounts counts;
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+		counts.counts[e] = -1;
+	counts.uncountedThreads = 0;
+	return counts;
+}
+
+void addPerfCounts(PerfCounts& total, const PerfCounts& counts)
+{
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+		if (counts.counts[e] >= 0)
+			total.counts[e] = std::max(total.counts[e], 0.0) + counts.counts[e];
+	total.uncountedThreads = std::max(total.uncountedThreads, counts.uncountedThreads);
+}
+
+bool perfCountsValid(const PerfCounts& counts)
+{
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+		if (counts.counts[e] >= 0)
+			return true;
+	return false;
+}
+
+double perfRatio(const PerfCounts& counts, PerfEvent numerator, PerfEvent denominator)
+{
+	if (counts.counts[numerator] < 0 || counts.counts[denominator] <= 0)
+		return -1;
+	return counts.counts[numerator] / counts.counts[denominator];
+}
+
+PerfCounters::~PerfCounters()
+{
+	close();
+}
+
+void PerfCounters::close()
+{
+#ifdef __linux__
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+		for (size_t k = 0; k < descriptors[e].size(); ++k)
+			::close(descriptors[e][k]);
+		descriptors[e].clear();
+	}
+#endif
+}
+
+bool PerfCounters::start()
+{
+	close();
+#ifdef __linux__
+	std::vector<int> threads = processThreads();
+	threadCount = (int)threads.size();
+	bool opened = false;
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+		for (size_t t = 0; t < threads.size(); ++t) {
+			int descriptor = openCounter(eventConfigs[e], threads[t]);
+			if (descriptor >= 0)
+				descriptors[e].push_back(descriptor);
+		}
+		opened = opened || !descriptors[e].empty();
+	}
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+		for (size_t k = 0; k < descriptors[e].size(); ++k) {
+			ioctl(descriptors[e][k], PERF_EVENT_IOC_RESET, 0);
+			ioctl(descriptors[e][k], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	return opened;
+#else
+	return false;
+#endif
+}
+
+PerfCounts PerfCounters::stop()
+{
+	PerfCounts counts = emptyPerfCounts();
+#ifdef __linux__
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+		for (size_t k = 0; k < descriptors[e].size(); ++k)
+			ioctl(descriptors[e][k], PERF_EVENT_IOC_DISABLE, 0);
+
+	for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+		if (descriptors[e].empty())
+			continue;
+		double sum = 0;
+		int unread = 0;
+		for (size_t k = 0; k < descriptors[e].size(); ++k) {
+			// value, time enabled, time running
+			uint64_t values[3];
+			if (read(descriptors[e][k], values, sizeof(values)) != (ssize_t)sizeof(values)) {
+				++unread;
+				continue;
+			}
+			if (values[2] != 0)
+				sum += (double)values[0] * values[1] / values[2];
+		}
+		counts.counts[e] = sum;
+		counts.uncountedThreads = std::max(counts.uncountedThreads, threadCount - (int)descriptors[e].size() + unread);
+	}
+	close();
+#endif
+	return counts;
+}
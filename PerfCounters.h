@@ -0,0 +1,91 @@
+/*
+ * PerfCounters.h
+ *
+ *  Hardware performance counters of all threads of the process, read through Linux perf_event_open.
+ */
+
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include <vector>
+
+/**
+* @brief Counted events
+*/
+enum PerfEvent {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,		// level 1 data cache read misses
+	PERF_LLC_MISSES,		// last level cache read misses
+	PERF_BRANCHES,
+	PERF_BRANCH_MISSES,
+	PERF_TASK_CLOCK,		// nanoseconds threads were running
+	PERF_EVENT_COUNT
+};
+
+/**
+* @brief Event counts summed over threads, scaled when the kernel multiplexed counters. Negative count means
+* the event could not be counted.
+*/
+struct PerfCounts {
+	double counts[PERF_EVENT_COUNT];
+	int uncountedThreads;	// most threads an available event could not be opened on, its count is too low then
+};
+
+/**
+* @brief Printable name of event
+*/
+const char* perfEventName(PerfEvent event);
+
+/**
+* @brief Counts are unavailable until added to
+*/
+PerfCounts emptyPerfCounts();
+
+/**
+* @brief Adds available counts to total, uncounted threads of total become the larger of both
+*/
+void addPerfCounts(PerfCounts& total, const PerfCounts& counts);
+
+/**
+* @brief Is any event counted
+*/
+bool perfCountsValid(const PerfCounts& counts);
+
+/**
+* @brief Ratio of two counts, for example instructions per cycle
+* @return negative if one of the events is unavailable or denominator is 0
+*/
+double perfRatio(const PerfCounts& counts, PerfEvent numerator, PerfEvent denominator);
+
+/**
+* @brief Counters of every thread of the process that exists when start is called. Threads created later are
+* not counted, so thread pools should be warmed up first. Only user space is counted.
+*/
+class PerfCounters {
+private:
+	std::vector<int> descriptors[PERF_EVENT_COUNT];
+	int threadCount;	// threads of the process at start
+
+	void close();
+public:
+	PerfCounters() : threadCount(0) {};
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	~PerfCounters();
+
+	/**
+	* @brief Opens, resets and enables counters
+	* @return false if no event can be counted, for example on other systems than Linux, when
+	* perf_event_paranoid forbids it or in virtual machines without counters
+	*/
+	bool start();
+
+	/**
+	* @brief Disables counters and reads them, events opened on fewer threads than existed at start are
+	* reported in uncountedThreads
+	*/
+	PerfCounts stop();
+};
+
+#endif /* PERFCOUNTERS_H_ */
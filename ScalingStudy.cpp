@@ -0,0 +1,63 @@
+/*
+ * ScalingStudy.cpp
+ *
+ *  Thread count scaling of implementation variants with speedup, efficiency and Karp-Flatt metric.
+ */
+
+#include "ScalingStudy.h"
+#include <stdio.h>
+#include <tbb/global_control.h>
+
+std::vector<ScalingResult> runScalingStudy(const std::string& filter, int width, int height, const std::vector<Variant>& variants,
+	int maxThreads, const BenchmarkOptions& options)
+{
+	std::vector<ScalingResult> results;
+	for (size_t v = 0; v < variants.size(); ++v) {
+		double oneThread = 0;
+		for (int threads = 1; threads <= maxThreads; ++threads) {
+			double seconds;
+			{
+				tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+				seconds = runBenchmark(variants[v].name, width, height, 0, options, variants[v].run).median;
+			}
+			if (threads == 1)
+				oneThread = seconds;
+
+			ScalingResult result = { filter, variants[v].name, width, height, threads, seconds, 0, 0, 0 };
+			result.speedup = seconds > 0 ? oneThread / seconds : 0;
+			result.efficiency = result.speedup / threads;
+			if (threads > 1 && result.speedup > 0)
+				result.serialFraction = (1 / result.speedup - 1.0 / threads) / (1 - 1.0 / threads);
+			results.push_back(result);
+		}
+	}
+	return results;
+}
+
+bool saveScalingResults(const char* filename, const std::vector<ScalingResult>& results)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	bool json = isJsonFileName(filename);
+	if (json)
+		fprintf(file, "[\n");
+	else
+		fprintf(file, "filter,variant,width,height,threads,seconds,speedup,efficiency,serial_fraction\n");
+
+	for (size_t k = 0; k < results.size(); ++k) {
+		const ScalingResult& r = results[k];
+		if (json)
+			fprintf(file, "  {\"filter\": \"%s\", \"variant\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %d, \"seconds\": %.9g, "
+				"\"speedup\": %.6g, \"efficiency\": %.6g, \"serial_fraction\": %.6g}%s\n", r.filter.c_str(), r.variant.c_str(), r.width,
+				r.height, r.threads, r.seconds, r.speedup, r.efficiency, r.serialFraction, k + 1 < results.size() ? "," : "");
+		else
+			fprintf(file, "%s,%s,%d,%d,%d,%.9g,%.6g,%.6g,%.6g\n", r.filter.c_str(), r.variant.c_str(), r.width, r.height, r.threads,
+				r.seconds, r.speedup, r.efficiency, r.serialFraction);
+	}
+
+	if (json)
+		fprintf(file, "]\n");
+	return fclose(file) == 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * ScalingStudy.h
+ *
+ *  Thread count scaling of implementation variants with speedup, efficiency and Karp-Flatt metric.
+ */
+
+#ifndef SCALINGSTUDY_H_
+#define SCALINGSTUDY_H_
+
+#include <string>
+#include <vector>
+#include "VariantProfile.h"
+#include "BenchmarkHarness.h"
+
+/**
+* @brief Timing of one variant on one thread count. Speedup is relative to the same variant on 1 thread,
+* serial fraction is the Karp-Flatt metric (1 / speedup - 1 / threads) / (1 - 1 / threads), 0 for 1 thread.
+*/
+struct ScalingResult {
+	std::string filter;
+	std::string variant;
+	int width;
+	int height;
+	int threads;
+	double seconds;
+	double speedup;
+	double efficiency;
+	double serialFraction;
+};
+
+/**
+* @brief Times every variant with TBB limited to 1 .. maxThreads threads by tbb::global_control.
+* Every time is the median of runs of runBenchmark.
+* @param filter name of the filter, copied to the results
+* @param width image width
+* @param height image height
+* @param variants TBB based variants, all of them compute the same output
+* @param maxThreads largest thread count
+* @param options warm up, repetitions and cache flushing of every thread count
+* @return results ordered by variant and thread count
+*/
+std::vector<ScalingResult> runScalingStudy(const std::string& filter, int width, int height, const std::vector<Variant>& variants,
+	int maxThreads, const BenchmarkOptions& options);
+
+/**
+* @brief Writes results as CSV with a header line, or as JSON array of objects if file name ends with .json
+* @param filename output file name
+* @param results results of runScalingStudy
+* @return false if file can not be written
+*/
+bool saveScalingResults(const char* filename, const std::vector<ScalingResult>& results);
+
+#endif /* SCALINGSTUDY_H_ */
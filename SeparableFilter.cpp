@@ -0,0 +1,358 @@
+/*
+ * SeparableFilter.cpp
+ *
+ *  Separable (row x column) execution of Prewitt style filters.
+ */
+
+#include "SeparableFilter.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+// coefficients are limited during decomposition so the accumulation bound below fits in long long
+#define MAX_TERM_COEFFICIENT	(1 << 16)
+// largest input pixel value the int accumulators have to hold
+#define MAX_PIXEL_VALUE			255
+
+namespace {
+
+/**
+* @brief Non zero coefficient of a 1-D filter
+*/
+struct Tap {
+	int index;
+	int coefficient;
+};
+
+std::vector<Tap> nonZeroTaps(const std::vector<int>& coefficients)
+{
+	std::vector<Tap> taps;
+	for (int i = 0; i < (int)coefficients.size(); ++i) {
+		if (coefficients[i] != 0) {
+			Tap tap = { i, coefficients[i] };
+			taps.push_back(tap);
+		}
+	}
+	return taps;
+}
+
+/**
+* @brief Line buffers of one separable term, line of input row r is kept at slot r % filterSize
+*/
+struct TermLines {
+	std::vector<Tap> rowTaps;
+	std::vector<Tap> columnTaps;
+	std::vector<int> lines;
+};
+
+/**
+* @brief Separable state of one filter (all its terms)
+*/
+struct FilterLines {
+	std::vector<TermLines> terms;
+
+	FilterLines(const KernelDecomposition& decomposition, int lineWidth)
+	{
+		terms.resize(decomposition.terms.size());
+		for (size_t t = 0; t < terms.size(); ++t) {
+			terms[t].rowTaps = nonZeroTaps(decomposition.terms[t].row);
+			terms[t].columnTaps = nonZeroTaps(decomposition.terms[t].column);
+			terms[t].lines.resize((size_t)decomposition.filterSize * lineWidth);
+		}
+	}
+
+	// horizontal pass of input row into its line buffer
+	template<typename InPixel>
+	void filterRow(const InPixel* inRow, int slot, int lineWidth)
+	{
+		for (size_t t = 0; t < terms.size(); ++t) {
+			int* line = &terms[t].lines[(size_t)slot * lineWidth];
+			std::fill(line, line + lineWidth, 0);
+			for (size_t k = 0; k < terms[t].rowTaps.size(); ++k) {
+				const InPixel* in = inRow + terms[t].rowTaps[k].index;
+				int coefficient = terms[t].rowTaps[k].coefficient;
+				for (int x = 0; x < lineWidth; ++x)
+					line[x] += coefficient * in[x];
+			}
+		}
+	}
+
+	// vertical pass combining line buffers of rows firstRow .. firstRow + filterSize - 1
+	void combineRows(int* sum, int firstRow, int filterSize, int lineWidth) const
+	{
+		std::fill(sum, sum + lineWidth, 0);
+		for (size_t t = 0; t < terms.size(); ++t) {
+			for (size_t k = 0; k < terms[t].columnTaps.size(); ++k) {
+				int slot = (firstRow + terms[t].columnTaps[k].index) % filterSize;
+				const int* line = &terms[t].lines[(size_t)slot * lineWidth];
+				int coefficient = terms[t].columnTaps[k].coefficient;
+				for (int x = 0; x < lineWidth; ++x)
+					sum[x] += coefficient * line[x];
+			}
+		}
+	}
+};
+
+int termCost(const std::vector<SeparableTerm>& terms, long long& magnitude)
+{
+	int taps = 0;
+	magnitude = 0;
+	for (size_t t = 0; t < terms.size(); ++t) {
+		for (size_t j = 0; j < terms[t].row.size(); ++j) {
+			taps += (terms[t].row[j] != 0) + (terms[t].column[j] != 0);
+			magnitude += std::abs(terms[t].row[j]) + std::abs(terms[t].column[j]);
+		}
+	}
+	return taps;
+}
+
+/**
+* @brief Largest absolute value a line buffer or output sum can reach, sum over terms of
+* sum |row| * sum |column| * MAX_PIXEL_VALUE
+*/
+long long accumulationBound(const std::vector<SeparableTerm>& terms)
+{
+	long long bound = 0;
+	for (size_t t = 0; t < terms.size(); ++t) {
+		long long rowSum = 0, columnSum = 0;
+		for (size_t j = 0; j < terms[t].row.size(); ++j) {
+			rowSum += std::abs(terms[t].row[j]);
+			columnSum += std::abs(terms[t].column[j]);
+		}
+		bound += rowSum * columnSum * MAX_PIXEL_VALUE;
+	}
+	return bound;
+}
+
+int gcd(int a, int b)
+{
+	a = std::abs(a);
+	b = std::abs(b);
+	while (b != 0) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+* @brief Moves common factor of the row vector into the column vector
+*/
+void normalizeTerm(SeparableTerm& term)
+{
+	int divisor = 0;
+	for (size_t j = 0; j < term.row.size(); ++j)
+		divisor = gcd(divisor, term.row[j]);
+	if (divisor <= 1)
+		return;
+	for (size_t j = 0; j < term.row.size(); ++j) {
+		term.row[j] /= divisor;
+		term.column[j] *= divisor;
+	}
+}
+
+/**
+* @brief Adds q times vector of term t to the vector of term s on one side, and subtracts q times the
+* other side vector of term s from term t, which keeps the sum of products unchanged
+*/
+void shearTerms(SeparableTerm& s, SeparableTerm& t, int q, bool rows)
+{
+	std::vector<int>& target = rows ? s.row : s.column;
+	const std::vector<int>& source = rows ? t.row : t.column;
+	std::vector<int>& compensated = rows ? t.column : t.row;
+	const std::vector<int>& compensation = rows ? s.column : s.row;
+	for (size_t k = 0; k < target.size(); ++k) {
+		target[k] += q * source[k];
+		compensated[k] -= q * compensation[k];
+	}
+}
+
+/**
+* @brief Lowers the number of non zero taps of the decomposition.
+* Terms are sheared against each other (on row or column side) while that reduces the number
+* of taps, or the coefficient magnitude at equal tap count.
+*/
+void reduceTerms(std::vector<SeparableTerm>& terms)
+{
+	for (size_t t = 0; t < terms.size(); ++t)
+		normalizeTerm(terms[t]);
+
+	long long magnitude;
+	int taps = termCost(terms, magnitude);
+	bool improved = true;
+	while (improved) {
+		improved = false;
+		for (size_t s = 0; s < terms.size(); ++s) {
+			for (size_t t = 0; t < terms.size(); ++t) {
+				for (int side = 0; side < 2 && s != t; ++side) {
+					bool rows = side == 0;
+					for (size_t j = 0; j < terms[t].row.size(); ++j) {
+						int sourceValue = rows ? terms[t].row[j] : terms[t].column[j];
+						int targetValue = rows ? terms[s].row[j] : terms[s].column[j];
+						if (sourceValue == 0 || targetValue == 0 || targetValue % sourceValue != 0)
+							continue;
+
+						std::vector<SeparableTerm> candidate = terms;
+						shearTerms(candidate[s], candidate[t], -targetValue / sourceValue, rows);
+						long long candidateMagnitude;
+						int candidateTaps = termCost(candidate, candidateMagnitude);
+						if (candidateTaps < taps || (candidateTaps == taps && candidateMagnitude < magnitude)) {
+							terms.swap(candidate);
+							taps = candidateTaps;
+							magnitude = candidateMagnitude;
+							improved = true;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+}
+
+bool decomposeKernel(const int* filter, int filterSize, KernelDecomposition& decomposition)
+{
+	decomposition.filterSize = filterSize;
+	decomposition.terms.clear();
+
+	std::vector<std::vector<long long> > basis(filterSize);
+	for (int i = 0; i < filterSize; ++i)
+		basis[i].assign(filter + i * filterSize, filter + (i + 1) * filterSize);
+
+	// integer row echelon form, pivot of each column is found with euclid steps between rows
+	int rank = 0;
+	std::vector<int> pivotColumns;
+	for (int col = 0; col < filterSize && rank < filterSize; ++col) {
+		while (true) {
+			int pivot = -1;
+			for (int r = rank; r < filterSize; ++r)
+				if (basis[r][col] != 0 && (pivot == -1 || std::llabs(basis[r][col]) < std::llabs(basis[pivot][col])))
+					pivot = r;
+			if (pivot == -1)
+				break;
+			std::swap(basis[rank], basis[pivot]);
+
+			bool reduced = true;
+			for (int r = rank + 1; r < filterSize; ++r) {
+				long long quotient = basis[r][col] / basis[rank][col];
+				for (int j = 0; j < filterSize; ++j)
+					basis[r][j] -= quotient * basis[rank][j];
+				if (basis[r][col] != 0)
+					reduced = false;
+			}
+			if (reduced) {
+				if (basis[rank][col] < 0)
+					for (int j = 0; j < filterSize; ++j)
+						basis[rank][j] = -basis[rank][j];
+				pivotColumns.push_back(col);
+				++rank;
+				break;
+			}
+		}
+	}
+
+	if (rank == filterSize)
+		return false;
+
+	decomposition.terms.resize(rank);
+	for (int t = 0; t < rank; ++t) {
+		decomposition.terms[t].row.resize(filterSize);
+		decomposition.terms[t].column.assign(filterSize, 0);
+		for (int j = 0; j < filterSize; ++j) {
+			if (std::llabs(basis[t][j]) > MAX_TERM_COEFFICIENT)
+				return false;
+			decomposition.terms[t].row[j] = (int)basis[t][j];
+		}
+	}
+
+	// coefficients of every filter row in the echelon basis
+	for (int i = 0; i < filterSize; ++i) {
+		std::vector<long long> residual(filter + i * filterSize, filter + (i + 1) * filterSize);
+		for (int t = 0; t < rank; ++t) {
+			long long pivotValue = basis[t][pivotColumns[t]];
+			if (residual[pivotColumns[t]] % pivotValue != 0)
+				return false;
+			long long coefficient = residual[pivotColumns[t]] / pivotValue;
+			if (std::llabs(coefficient) > MAX_TERM_COEFFICIENT)
+				return false;
+			for (int j = 0; j < filterSize; ++j)
+				residual[j] -= coefficient * basis[t][j];
+			decomposition.terms[t].column[i] = (int)coefficient;
+		}
+		for (int j = 0; j < filterSize; ++j)
+			if (residual[j] != 0)
+				return false;
+	}
+
+	reduceTerms(decomposition.terms);
+
+	// |Gy| + |Gx| of both filters is summed in int, filters that could overflow it use generic path
+	if (accumulationBound(decomposition.terms) > INT_MAX / 2)
+		return false;
+	return true;
+}
+
+const KernelDecomposition* findKernelDecomposition(const int* filter, int filterSize)
+{
+	struct CachedDecomposition {
+		bool decomposable;
+		KernelDecomposition decomposition;
+	};
+	static std::map<std::vector<int>, CachedDecomposition> cache;
+	static std::mutex cacheMutex;
+
+	std::vector<int> key(filter, filter + filterSize * filterSize);
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::map<std::vector<int>, CachedDecomposition>::iterator it = cache.find(key);
+	if (it == cache.end()) {
+		CachedDecomposition entry;
+		entry.decomposable = decomposeKernel(filter, filterSize, entry.decomposition);
+		it = cache.insert(std::make_pair(key, entry)).first;
+	}
+	return it->second.decomposable ? &it->second.decomposition : nullptr;
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_separable_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const KernelDecomposition& filterVer,
+	const KernelDecomposition& filterHor, int rowStart, int rowEnd)
+{
+	int filterSize = filterVer.filterSize;
+	int offset = filterSize / 2;
+	int lineWidth = width - 2 * offset;
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
+	if (rowStart >= rowEnd || lineWidth <= 0)
+		return;
+
+	FilterLines linesVer(filterVer, lineWidth);
+	FilterLines linesHor(filterHor, lineWidth);
+	std::vector<int> sumGy(lineWidth), sumGx(lineWidth);
+
+	for (int r = rowStart - offset; r < rowStart + offset; ++r) {
+		linesVer.filterRow(inBuffer + r * width, r % filterSize, lineWidth);
+		linesHor.filterRow(inBuffer + r * width, r % filterSize, lineWidth);
+	}
+
+	for (int i = rowStart; i < rowEnd; ++i) {
+		int r = i + offset;
+		linesVer.filterRow(inBuffer + r * width, r % filterSize, lineWidth);
+		linesHor.filterRow(inBuffer + r * width, r % filterSize, lineWidth);
+
+		linesVer.combineRows(&sumGy[0], i - offset, filterSize, lineWidth);
+		linesHor.combineRows(&sumGx[0], i - offset, filterSize, lineWidth);
+
+		OutPixel* outRow = outBuffer + i * width + offset;
+		for (int x = 0; x < lineWidth; ++x)
+			outRow[x] = std::abs(sumGy[x]) + std::abs(sumGx[x]) >= 128 ? 255 : 0;
+	}
+}
+
+template void filter_separable_prewitt<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	const KernelDecomposition& filterVer, const KernelDecomposition& filterHor, int rowStart, int rowEnd);
+template void filter_separable_prewitt<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	const KernelDecomposition& filterVer, const KernelDecomposition& filterHor, int rowStart, int rowEnd);
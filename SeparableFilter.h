@@ -0,0 +1,67 @@
+/*
+ * SeparableFilter.h
+ *
+ *  Separable (row x column) execution of Prewitt style filters.
+ */
+
+#ifndef SEPARABLEFILTER_H_
+#define SEPARABLEFILTER_H_
+
+#include <vector>
+
+/**
+* @brief One separable term of a filter, filter[i * filterSize + j] == column[i] * row[j]
+*/
+struct SeparableTerm {
+	std::vector<int> column;
+	std::vector<int> row;
+};
+
+/**
+* @brief Filter written as a sum of separable terms
+*/
+struct KernelDecomposition {
+	int filterSize;
+	std::vector<SeparableTerm> terms;
+};
+
+/**
+* @brief Writes filter as a sum of integer separable terms (column * row products).
+* Rows of the filter are reduced to an echelon basis of their integer lattice, so every row is an
+* integer combination of basis rows and the decomposition is exact. Terms are then sheared against
+* each other to lower the number of non zero taps.
+* @param filter filter coefficients, filterSize x filterSize row major
+* @param filterSize size of the filter
+* @param decomposition filled with one term per basis row on success
+* @return true if the filter rank is lower than filterSize, false if it can not be decomposed or its int
+* accumulation could overflow for 8 bit pixels
+*/
+bool decomposeKernel(const int* filter, int filterSize, KernelDecomposition& decomposition);
+
+/**
+* @brief Cached version of decomposeKernel, every distinct filter is decomposed only once. Thread safe.
+* @param filter filter coefficients, filterSize x filterSize row major
+* @param filterSize size of the filter
+* @return decomposition of the filter, nullptr if it can not be decomposed
+*/
+const KernelDecomposition* findKernelDecomposition(const int* filter, int filterSize);
+
+/**
+* @brief Edge detection using Prewitt operator where both filters are given as sums of separable terms.
+* Every row is filtered horizontally once into a line buffer and output rows are combined
+* vertically from the last filterSize line buffers. Result is identical to filter_serial_prewitt.
+* Instantiated for uint8_t and int pixels.
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer decomposition of vertical component filter
+* @param filterHor decomposition of horizontal component filter
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_separable_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const KernelDecomposition& filterVer,
+	const KernelDecomposition& filterHor, int rowStart, int rowEnd);
+
+#endif /* SEPARABLEFILTER_H_ */
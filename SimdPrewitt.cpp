@@ -0,0 +1,424 @@
+/*
+ * SimdPrewitt.cpp
+ *
+ *  Vectorized Prewitt operator with runtime instruction set dispatch.
+ */
+
+#include "SimdPrewitt.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+/**
+* @brief Window position with at least one non zero coefficient
+*/
+struct WindowTap {
+	int delta;
+	int ver;
+	int hor;
+};
+
+std::vector<WindowTap> windowTaps(int width, const int* filterVer, const int* filterHor, int filterSize)
+{
+	std::vector<WindowTap> taps;
+	for (int i = 0; i < filterSize; ++i) {
+		for (int j = 0; j < filterSize; ++j) {
+			int k = i * filterSize + j;
+			if (filterVer[k] != 0 || filterHor[k] != 0) {
+				WindowTap tap = { i * width + j, filterVer[k], filterHor[k] };
+				taps.push_back(tap);
+			}
+		}
+	}
+	return taps;
+}
+
+template<typename InPixel>
+inline int scalarPixel(const InPixel* window, const std::vector<WindowTap>& taps)
+{
+	int sumGy = 0, sumGx = 0;
+	for (size_t k = 0; k < taps.size(); ++k) {
+		sumGy += window[taps[k].delta] * taps[k].ver;
+		sumGx += window[taps[k].delta] * taps[k].hor;
+	}
+	return std::abs(sumGy) + std::abs(sumGx) >= 128 ? 255 : 0;
+}
+
+// window of output pixel outRow[x] starts at windowRow[x]
+template<typename InPixel, typename OutPixel>
+void scalarRow(const InPixel* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps)
+{
+	for (int x = 0; x < count; ++x)
+		outRow[x] = scalarPixel(windowRow + x, taps);
+}
+
+#ifdef SIMD_X86
+
+// loads widen pixels to lanes, stores turn all ones lanes into 255 pixels
+
+TARGET_SSE41 inline __m128i load4x32(const int* pixel)
+{
+	return _mm_loadu_si128((const __m128i*)pixel);
+}
+
+TARGET_SSE41 inline __m128i load4x32(const uint8_t* pixel)
+{
+	int packed;
+	memcpy(&packed, pixel, sizeof(packed));
+	return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+}
+
+TARGET_SSE41 inline void store4x32(int* pixel, __m128i mask)
+{
+	_mm_storeu_si128((__m128i*)pixel, _mm_and_si128(mask, _mm_set1_epi32(255)));
+}
+
+TARGET_SSE41 inline void store4x32(uint8_t* pixel, __m128i mask)
+{
+	__m128i words = _mm_packs_epi32(mask, mask);
+	int packed = _mm_cvtsi128_si32(_mm_packs_epi16(words, words));
+	memcpy(pixel, &packed, sizeof(packed));
+}
+
+TARGET_SSE41 inline __m128i load8x16(const uint8_t* pixel)
+{
+	return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)pixel));
+}
+
+TARGET_SSE41 inline void store8x16(int* pixel, __m128i mask)
+{
+	store4x32(pixel, _mm_cvtepi16_epi32(mask));
+	store4x32(pixel + 4, _mm_cvtepi16_epi32(_mm_srli_si128(mask, 8)));
+}
+
+TARGET_SSE41 inline void store8x16(uint8_t* pixel, __m128i mask)
+{
+	_mm_storel_epi64((__m128i*)pixel, _mm_packs_epi16(mask, mask));
+}
+
+TARGET_AVX2 inline __m256i load8x32(const int* pixel)
+{
+	return _mm256_loadu_si256((const __m256i*)pixel);
+}
+
+TARGET_AVX2 inline __m256i load8x32(const uint8_t* pixel)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)pixel));
+}
+
+TARGET_AVX2 inline void store8x32(int* pixel, __m256i mask)
+{
+	_mm256_storeu_si256((__m256i*)pixel, _mm256_and_si256(mask, _mm256_set1_epi32(255)));
+}
+
+TARGET_AVX2 inline void store8x32(uint8_t* pixel, __m256i mask)
+{
+	__m256i words = _mm256_packs_epi32(mask, mask);
+	__m256i bytes = _mm256_packs_epi16(words, words);
+	bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+	_mm_storel_epi64((__m128i*)pixel, _mm256_castsi256_si128(bytes));
+}
+
+TARGET_AVX2 inline __m256i load16x16(const uint8_t* pixel)
+{
+	return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)pixel));
+}
+
+TARGET_AVX2 inline void store16x16(int* pixel, __m256i mask)
+{
+	store8x32(pixel, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(mask)));
+	store8x32(pixel + 8, _mm256_cvtepi16_epi32(_mm256_extracti128_si256(mask, 1)));
+}
+
+TARGET_AVX2 inline void store16x16(uint8_t* pixel, __m256i mask)
+{
+	__m256i bytes = _mm256_permute4x64_epi64(_mm256_packs_epi16(mask, mask), 0xD8);
+	_mm_storeu_si128((__m128i*)pixel, _mm256_castsi256_si128(bytes));
+}
+
+template<typename InPixel, typename OutPixel>
+TARGET_SSE41 void sse41Row(const InPixel* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps)
+{
+	const __m128i threshold = _mm_set1_epi32(127);
+	int x = 0;
+	for (; x + 4 <= count; x += 4) {
+		__m128i sumGy = _mm_setzero_si128();
+		__m128i sumGx = _mm_setzero_si128();
+		for (size_t k = 0; k < taps.size(); ++k) {
+			__m128i value = load4x32(windowRow + x + taps[k].delta);
+			if (taps[k].ver != 0)
+				sumGy = _mm_add_epi32(sumGy, _mm_mullo_epi32(value, _mm_set1_epi32(taps[k].ver)));
+			if (taps[k].hor != 0)
+				sumGx = _mm_add_epi32(sumGx, _mm_mullo_epi32(value, _mm_set1_epi32(taps[k].hor)));
+		}
+		__m128i g = _mm_add_epi32(_mm_abs_epi32(sumGy), _mm_abs_epi32(sumGx));
+		store4x32(outRow + x, _mm_cmpgt_epi32(g, threshold));
+	}
+	scalarRow(windowRow + x, outRow + x, count - x, taps);
+}
+
+// int16_t lanes, |Gy| + |Gx| may not fit in int16_t so it is compared as unsigned
+template<typename OutPixel>
+TARGET_SSE41 void sse41NarrowRow(const uint8_t* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps)
+{
+	const __m128i threshold = _mm_set1_epi16(128);
+	int x = 0;
+	for (; x + 8 <= count; x += 8) {
+		__m128i sumGy = _mm_setzero_si128();
+		__m128i sumGx = _mm_setzero_si128();
+		for (size_t k = 0; k < taps.size(); ++k) {
+			__m128i value = load8x16(windowRow + x + taps[k].delta);
+			if (taps[k].ver != 0)
+				sumGy = _mm_add_epi16(sumGy, _mm_mullo_epi16(value, _mm_set1_epi16((short)taps[k].ver)));
+			if (taps[k].hor != 0)
+				sumGx = _mm_add_epi16(sumGx, _mm_mullo_epi16(value, _mm_set1_epi16((short)taps[k].hor)));
+		}
+		__m128i g = _mm_add_epi16(_mm_abs_epi16(sumGy), _mm_abs_epi16(sumGx));
+		store8x16(outRow + x, _mm_cmpeq_epi16(_mm_max_epu16(g, threshold), g));
+	}
+	scalarRow(windowRow + x, outRow + x, count - x, taps);
+}
+
+template<typename InPixel, typename OutPixel>
+TARGET_AVX2 void avx2Row(const InPixel* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps)
+{
+	const __m256i threshold = _mm256_set1_epi32(127);
+	int x = 0;
+	for (; x + 8 <= count; x += 8) {
+		__m256i sumGy = _mm256_setzero_si256();
+		__m256i sumGx = _mm256_setzero_si256();
+		for (size_t k = 0; k < taps.size(); ++k) {
+			__m256i value = load8x32(windowRow + x + taps[k].delta);
+			if (taps[k].ver != 0)
+				sumGy = _mm256_add_epi32(sumGy, _mm256_mullo_epi32(value, _mm256_set1_epi32(taps[k].ver)));
+			if (taps[k].hor != 0)
+				sumGx = _mm256_add_epi32(sumGx, _mm256_mullo_epi32(value, _mm256_set1_epi32(taps[k].hor)));
+		}
+		__m256i g = _mm256_add_epi32(_mm256_abs_epi32(sumGy), _mm256_abs_epi32(sumGx));
+		store8x32(outRow + x, _mm256_cmpgt_epi32(g, threshold));
+	}
+	scalarRow(windowRow + x, outRow + x, count - x, taps);
+}
+
+// int16_t lanes, |Gy| + |Gx| may not fit in int16_t so it is compared as unsigned
+template<typename OutPixel>
+TARGET_AVX2 void avx2NarrowRow(const uint8_t* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps)
+{
+	const __m256i threshold = _mm256_set1_epi16(128);
+	int x = 0;
+	for (; x + 16 <= count; x += 16) {
+		__m256i sumGy = _mm256_setzero_si256();
+		__m256i sumGx = _mm256_setzero_si256();
+		for (size_t k = 0; k < taps.size(); ++k) {
+			__m256i value = load16x16(windowRow + x + taps[k].delta);
+			if (taps[k].ver != 0)
+				sumGy = _mm256_add_epi16(sumGy, _mm256_mullo_epi16(value, _mm256_set1_epi16((short)taps[k].ver)));
+			if (taps[k].hor != 0)
+				sumGx = _mm256_add_epi16(sumGx, _mm256_mullo_epi16(value, _mm256_set1_epi16((short)taps[k].hor)));
+		}
+		__m256i g = _mm256_add_epi16(_mm256_abs_epi16(sumGy), _mm256_abs_epi16(sumGx));
+		store16x16(outRow + x, _mm256_cmpeq_epi16(_mm256_max_epu16(g, threshold), g));
+	}
+	scalarRow(windowRow + x, outRow + x, count - x, taps);
+}
+
+void cpuid(int leaf, int subleaf, unsigned int registers[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; ++i)
+		registers[i] = (unsigned int)info[i];
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// operating system has to save YMM registers on context switch
+bool osSupportsAvx()
+{
+#if defined(_MSC_VER)
+	return (_xgetbv(0) & 0x6) == 0x6;
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (eax & 0x6) == 0x6;
+#endif
+}
+
+#endif
+
+template<typename InPixel, typename OutPixel>
+using SimdRow = void (*)(const InPixel* windowRow, OutPixel* outRow, int count, const std::vector<WindowTap>& taps);
+
+template<typename InPixel, typename OutPixel>
+SimdRow<InPixel, OutPixel> simdRow(SimdLevel level)
+{
+#ifdef SIMD_X86
+	switch (level) {
+	case SIMD_AVX2:
+		return avx2Row<InPixel, OutPixel>;
+	case SIMD_SSE41:
+		return sse41Row<InPixel, OutPixel>;
+	default:
+		break;
+	}
+#endif
+	return scalarRow<InPixel, OutPixel>;
+}
+
+/**
+* @brief int16_t lane kernels, only 8 bit input has them
+*/
+template<typename InPixel, typename OutPixel>
+struct NarrowRow {
+	static SimdRow<InPixel, OutPixel> get(SimdLevel) { return nullptr; }
+};
+
+template<typename OutPixel>
+struct NarrowRow<uint8_t, OutPixel> {
+	static SimdRow<uint8_t, OutPixel> get(SimdLevel level)
+	{
+#ifdef SIMD_X86
+		switch (level) {
+		case SIMD_AVX2:
+			return avx2NarrowRow<OutPixel>;
+		case SIMD_SSE41:
+			return sse41NarrowRow<OutPixel>;
+		default:
+			break;
+		}
+#endif
+		return nullptr;
+	}
+};
+
+// largest gradient for 8 bit input has to fit in int16_t lanes
+bool fitsNarrowLanes(const int* filter, int filterSize)
+{
+	int sum = 0;
+	for (int k = 0; k < filterSize * filterSize; ++k)
+		sum += std::abs(filter[k]);
+	return sum * 255 <= 32767;
+}
+
+}
+
+SimdLevel detectSimdLevel()
+{
+	static const SimdLevel level = []() {
+#ifdef SIMD_X86
+		unsigned int registers[4];
+		cpuid(0, 0, registers);
+		unsigned int maxLeaf = registers[0];
+		if (maxLeaf < 1)
+			return SIMD_SCALAR;
+
+		cpuid(1, 0, registers);
+		bool sse41 = (registers[2] & (1u << 19)) != 0;
+		bool osxsave = (registers[2] & (1u << 27)) != 0;
+		bool avx = (registers[2] & (1u << 28)) != 0;
+		if (maxLeaf >= 7 && osxsave && avx && osSupportsAvx()) {
+			cpuid(7, 0, registers);
+			if (registers[1] & (1u << 5))
+				return SIMD_AVX2;
+		}
+		if (sse41)
+			return SIMD_SSE41;
+#endif
+		return SIMD_SCALAR;
+	}();
+	return level;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_AVX2:
+		return "AVX2";
+	case SIMD_SSE41:
+		return "SSE4.1";
+	default:
+		return "scalar";
+	}
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(SimdLevel level, InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd)
+{
+	int offset = filterSize / 2;
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
+	columnStart = std::max(columnStart, offset);
+	columnEnd = std::min(columnEnd, width - offset);
+	int count = columnEnd - columnStart;
+	if (rowStart >= rowEnd || count <= 0)
+		return;
+
+	std::vector<WindowTap> taps = windowTaps(width, filterVer, filterHor, filterSize);
+	SimdRow<InPixel, OutPixel> row = simdRow<InPixel, OutPixel>(level);
+	SimdRow<InPixel, OutPixel> narrowRow = NarrowRow<InPixel, OutPixel>::get(level);
+	if (narrowRow && fitsNarrowLanes(filterVer, filterSize) && fitsNarrowLanes(filterHor, filterSize))
+		row = narrowRow;
+
+	for (int i = rowStart; i < rowEnd; ++i)
+		row(inBuffer + (i - offset) * width + columnStart - offset, outBuffer + i * width + columnStart, count, taps);
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(SimdLevel level, InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd)
+{
+	filter_simd_prewitt(level, inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, 0, width);
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd)
+{
+	filter_simd_prewitt(detectSimdLevel(), inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, 0, width);
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd)
+{
+	filter_simd_prewitt(detectSimdLevel(), inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd,
+		columnStart, columnEnd);
+}
+
+template void filter_simd_prewitt<uint8_t, uint8_t>(SimdLevel level, uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_simd_prewitt<int, int>(SimdLevel level, int* inBuffer, int* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_simd_prewitt<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_simd_prewitt<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd);
+template void filter_simd_prewitt<uint8_t, uint8_t>(SimdLevel level, uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_simd_prewitt<int, int>(SimdLevel level, int* inBuffer, int* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_simd_prewitt<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_simd_prewitt<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	const int* filterVer, const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
@@ -0,0 +1,69 @@
+/*
+ * SimdPrewitt.h
+ *
+ *  Vectorized Prewitt operator with runtime instruction set dispatch.
+ */
+
+#ifndef SIMDPREWITT_H_
+#define SIMDPREWITT_H_
+
+/**
+* @brief Instruction sets the vectorized Prewitt operator is built for
+*/
+enum SimdLevel {
+	SIMD_SCALAR,
+	SIMD_SSE41,
+	SIMD_AVX2
+};
+
+/**
+* @brief Best instruction set supported by CPU and operating system, checked with CPUID once
+*/
+SimdLevel detectSimdLevel();
+
+/**
+* @brief Printable name of instruction set
+*/
+const char* simdLevelName(SimdLevel level);
+
+/**
+* @brief Edge detection using Prewitt operator, several output pixels are computed per iteration.
+* For uint8_t input whose gradients fit in 16 bits 16 (AVX2) or 8 (SSE4.1) pixels are done at once
+* in int16_t lanes, otherwise 8 (AVX2) or 4 (SSE4.1) in int lanes. Implementation is picked by
+* detectSimdLevel. Result is identical to filter_serial_prewitt. Instantiated for uint8_t and int pixels.
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd);
+
+/**
+* @brief Same as filter_simd_prewitt, but with explicitly chosen instruction set (must be supported)
+*/
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(SimdLevel level, InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd);
+
+/**
+* @brief Same as filter_simd_prewitt, limited to output columns columnStart .. columnEnd - 1
+*/
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+
+/**
+* @brief Same as filter_simd_prewitt limited to output columns, with explicitly chosen instruction set (must be supported)
+*/
+template<typename InPixel, typename OutPixel>
+void filter_simd_prewitt(SimdLevel level, InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer,
+	const int* filterHor, int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd);
+
+#endif /* SIMDPREWITT_H_ */
@@ -0,0 +1,147 @@
+/*
+ * SlidingWindowEdges.cpp
+ *
+ *  Edge detection with running window minimum and maximum (van Herk/Gil-Werman).
+ */
+
+#include "SlidingWindowEdges.h"
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct MinOp {
+	T operator()(T a, T b) const { return std::min(a, b); }
+};
+
+template<typename T>
+struct MaxOp {
+	T operator()(T a, T b) const { return std::max(a, b); }
+};
+
+/**
+* @brief Running window of size window over in[0 .. count + window - 2], out[x] = op(in[x .. x + window - 1]).
+* In blocks of window elements prefix and suffix are accumulated, every window spans at most two blocks.
+*/
+template<typename T, typename Op>
+void slidingRow(const T* in, T* out, int count, int window, T* prefix, T* suffix, Op op)
+{
+	int n = count + window - 1;
+	for (int blockStart = 0; blockStart < n; blockStart += window) {
+		int blockEnd = std::min(blockStart + window, n);
+		prefix[blockStart] = in[blockStart];
+		for (int x = blockStart + 1; x < blockEnd; ++x)
+			prefix[x] = op(prefix[x - 1], in[x]);
+		suffix[blockEnd - 1] = in[blockEnd - 1];
+		for (int x = blockEnd - 2; x >= blockStart; --x)
+			suffix[x] = op(suffix[x + 1], in[x]);
+	}
+	for (int x = 0; x < count; ++x)
+		out[x] = op(suffix[x], prefix[x + window - 1]);
+}
+
+// out[x] = op(a[x], b[x])
+template<typename T, typename Op>
+void combineLines(const T* a, const T* b, T* out, int count, Op op)
+{
+	for (int x = 0; x < count; ++x)
+		out[x] = op(a[x], b[x]);
+}
+
+/**
+* @brief Vertical running window over lines of horizontal results. For output rows starting at block
+* row s0, suffix accumulation is done over lines s0 .. s0 + window - 1 and prefix accumulation over the
+* following lines, window starting at s0 + k is op(suffix[k], prefix[k - 1]).
+*/
+template<typename T, typename Op>
+struct VerticalWindow {
+	int lineWidth;
+	int window;
+	Op op;
+	std::vector<T> block;
+	std::vector<T> next;
+
+	VerticalWindow(int lineWidth, int window) : lineWidth(lineWidth), window(window),
+		block((size_t)window * lineWidth), next((size_t)window * lineWidth) {}
+
+	T* blockLine(int k) { return &block[(size_t)k * lineWidth]; }
+	T* nextLine(int k) { return &next[(size_t)k * lineWidth]; }
+
+	// blockLine and nextLine hold horizontal results, count lines of output are produced
+	void accumulate(int count)
+	{
+		for (int k = window - 2; k >= 0; --k)
+			combineLines(blockLine(k), blockLine(k + 1), blockLine(k), lineWidth, op);
+		for (int k = 1; k < count - 1; ++k)
+			combineLines(nextLine(k - 1), nextLine(k), nextLine(k), lineWidth, op);
+	}
+
+	const T* result(int k, T* scratch)
+	{
+		if (k == 0)
+			return blockLine(0);
+		combineLines(blockLine(k), nextLine(k - 1), scratch, lineWidth, op);
+		return scratch;
+	}
+};
+
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_sliding_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd, int columnStart, int columnEnd)
+{
+	int offset = lookupWidth / 2;
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
+	columnStart = std::max(columnStart, offset);
+	columnEnd = std::min(columnEnd, width - offset);
+	int lineWidth = columnEnd - columnStart;
+	if (rowStart >= rowEnd || lineWidth <= 0)
+		return;
+
+	std::vector<InPixel> prefix(lineWidth + 2 * offset), suffix(lineWidth + 2 * offset), maxLine(lineWidth), minLine(lineWidth);
+	VerticalWindow<InPixel, MaxOp<InPixel> > windowMax(lineWidth, lookupWidth);
+	VerticalWindow<InPixel, MinOp<InPixel> > windowMin(lineWidth, lookupWidth);
+
+	for (int groupStart = rowStart; groupStart < rowEnd; groupStart += lookupWidth) {
+		int count = std::min(lookupWidth, rowEnd - groupStart);
+		int firstRow = groupStart - offset;
+
+		for (int k = 0; k < lookupWidth + count - 1; ++k) {
+			const InPixel* inRow = inBuffer + (firstRow + k) * width + columnStart - offset;
+			InPixel* lineMax = k < lookupWidth ? windowMax.blockLine(k) : windowMax.nextLine(k - lookupWidth);
+			InPixel* lineMin = k < lookupWidth ? windowMin.blockLine(k) : windowMin.nextLine(k - lookupWidth);
+			slidingRow(inRow, lineMax, lineWidth, lookupWidth, &prefix[0], &suffix[0], MaxOp<InPixel>());
+			slidingRow(inRow, lineMin, lineWidth, lookupWidth, &prefix[0], &suffix[0], MinOp<InPixel>());
+		}
+		windowMax.accumulate(count);
+		windowMin.accumulate(count);
+
+		for (int k = 0; k < count; ++k) {
+			const InPixel* rowMax = windowMax.result(k, &maxLine[0]);
+			const InPixel* rowMin = windowMin.result(k, &minLine[0]);
+			OutPixel* outRow = outBuffer + (groupStart + k) * width + columnStart;
+			for (int x = 0; x < lineWidth; ++x)
+				outRow[x] = rowMax[x] >= 128 && rowMin[x] < 128 ? 255 : 0;
+		}
+	}
+}
+
+template<typename InPixel, typename OutPixel>
+void filter_sliding_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd)
+{
+	filter_sliding_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, 0, width);
+}
+
+template void filter_sliding_edge_detection<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
+template void filter_sliding_edge_detection<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd);
+template void filter_sliding_edge_detection<uint8_t, uint8_t>(uint8_t* inBuffer, uint8_t* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd, int columnStart, int columnEnd);
+template void filter_sliding_edge_detection<int, int>(int* inBuffer, int* outBuffer, int width, int height,
+	int lookupWidth, int rowStart, int rowEnd, int columnStart, int columnEnd);
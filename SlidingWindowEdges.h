@@ -0,0 +1,34 @@
+/*
+ * SlidingWindowEdges.h
+ *
+ *  Edge detection with running window minimum and maximum (van Herk/Gil-Werman).
+ */
+
+#ifndef SLIDINGWINDOWEDGES_H_
+#define SLIDINGWINDOWEDGES_H_
+
+/**
+* @brief Edge detection algorithm where window minimum and maximum are computed with separable
+* van Herk/Gil-Werman passes, so cost per pixel does not depend on lookupWidth. Pixel is part of the
+* edge if maximum of its window is >= 128 and minimum is < 128, result is identical to
+* filter_serial_edge_detection. Instantiated for uint8_t and int pixels.
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<typename InPixel, typename OutPixel>
+void filter_sliding_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd);
+
+/**
+* @brief Same as filter_sliding_edge_detection, limited to output columns columnStart .. columnEnd - 1
+*/
+template<typename InPixel, typename OutPixel>
+void filter_sliding_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	int rowStart, int rowEnd, int columnStart, int columnEnd);
+
+#endif /* SLIDINGWINDOWEDGES_H_ */
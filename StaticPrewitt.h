@@ -0,0 +1,89 @@
+/*
+ * StaticPrewitt.h
+ *
+ *  Prewitt operator specialized at compile time for fixed filters.
+ */
+
+#ifndef STATICPREWITT_H_
+#define STATICPREWITT_H_
+
+#include <stdlib.h>
+#include <utility>
+
+/**
+* @brief Type of row range Prewitt implementation specialized for one pair of filters
+*/
+template<typename InPixel, typename OutPixel>
+using PrewittRows = void (*)(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int rowStart, int rowEnd);
+
+/**
+* @brief One filter tap with coefficient known at compile time, zero taps do not read memory
+*/
+template<int Coefficient>
+struct StaticTap {
+	template<typename Pixel>
+	static inline int apply(const Pixel* pixel) { return Coefficient * *pixel; }
+};
+
+template<>
+struct StaticTap<0> {
+	template<typename Pixel>
+	static inline int apply(const Pixel*) { return 0; }
+};
+
+/**
+* @brief Fully unrolled convolution of filterSize x filterSize window with the filter
+* @param window top left pixel of the window
+* @param width image width
+*/
+template<int Size, const int* Filter, typename Pixel, size_t... Index>
+inline int staticConvolve(const Pixel* window, int width, std::index_sequence<Index...>)
+{
+	int sum = 0;
+	int unrolled[] = { 0, (sum += StaticTap<Filter[Index]>::apply(window + (int)(Index / Size) * width + (int)(Index % Size)), 0)... };
+	(void)unrolled;
+	return sum;
+}
+
+/**
+* @brief Convolves submatrix and filters known at compile time and returns G
+* @param pixelRow current pixel row value
+* @param pixelColumn current pixel column value
+* @param inBuffer buffer of input image
+* @param width image width
+*/
+template<int Size, const int* FilterVer, const int* FilterHor, typename Pixel>
+inline int prewitt(int pixelRow, int pixelColumn, const Pixel* inBuffer, int width)
+{
+	const Pixel* window = inBuffer + (pixelRow - Size / 2) * width + (pixelColumn - Size / 2);
+	int sumGy = staticConvolve<Size, FilterVer>(window, width, std::make_index_sequence<Size * Size>());
+	int sumGx = staticConvolve<Size, FilterHor>(window, width, std::make_index_sequence<Size * Size>());
+	return std::abs(sumGy) + std::abs(sumGx);
+}
+
+/**
+* @brief Edge detection using Prewitt operator specialized for filters known at compile time
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param rowStart from where does row processing start
+* @param rowEnd where does row processing end
+*/
+template<int Size, const int* FilterVer, const int* FilterHor, typename InPixel, typename OutPixel>
+void filter_static_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int rowStart, int rowEnd)
+{
+	int offset = Size / 2;
+	if (rowStart < offset)
+		rowStart = offset;
+	if (rowEnd > height - offset)
+		rowEnd = height - offset;
+
+	for (int i = rowStart; i < rowEnd; ++i) {
+		for (int j = offset; j < width - offset; ++j) {
+			outBuffer[i * width + j] = prewitt<Size, FilterVer, FilterHor>(i, j, inBuffer, width) >= 128 ? 255 : 0;
+		}
+	}
+}
+
+#endif /* STATICPREWITT_H_ */
@@ -0,0 +1,117 @@
+/*
+ * SyntheticImage.cpp
+ *
+ *  Deterministic generated grayscale test images of any size.
+ */
+
+#include "SyntheticImage.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#define DEFAULT_CHECKER_SCALE		16
+#define DEFAULT_SPARSE_SCALE		256
+#define DEFAULT_DENSE_SCALE			4
+#define DARK_BLOCK					32
+#define BRIGHT_BLOCK				224
+
+namespace {
+
+const char* const patternNames[] = { "gradient", "checkerboard", "noise", "sparse_edges", "dense_edges" };
+
+// avalanche hash, every pixel gets an independent value so rows can be generated in any order
+inline uint32_t hashPixel(uint32_t column, uint32_t row, uint32_t seed)
+{
+	uint32_t h = column * 0x9E3779B1u ^ (row + seed * 0x632BE5ABu) * 0x85EBCA77u;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	h *= 0x297A2D39u;
+	h ^= h >> 15;
+	return h;
+}
+
+int defaultScale(SyntheticPattern pattern)
+{
+	switch (pattern) {
+	case PATTERN_CHECKERBOARD:
+		return DEFAULT_CHECKER_SCALE;
+	case PATTERN_SPARSE_EDGES:
+		return DEFAULT_SPARSE_SCALE;
+	case PATTERN_DENSE_EDGES:
+		return DEFAULT_DENSE_SCALE;
+	default:
+		return 1;
+	}
+}
+
+}
+
+const char* syntheticPatternName(SyntheticPattern pattern)
+{
+	return patternNames[pattern];
+}
+
+bool parseSyntheticImage(const char* text, SyntheticImage& image)
+{
+	const char* colon = strchr(text, ':');
+	if (colon == NULL)
+		return false;
+
+	int pattern = -1;
+	for (int k = 0; k < (int)(sizeof(patternNames) / sizeof(patternNames[0])); ++k)
+		if (strlen(patternNames[k]) == (size_t)(colon - text) && strncmp(text, patternNames[k], colon - text) == 0)
+			pattern = k;
+
+	int width, height, scale = 0;
+	char end;
+	int fields = sscanf(colon + 1, "%dx%d:%d%c", &width, &height, &scale, &end);
+	if (pattern < 0 || fields < 2 || fields > 3 || width <= 0 || height <= 0 || scale < 0)
+		return false;
+	if (fields == 2 && sscanf(colon + 1, "%dx%d%c", &width, &height, &end) != 2)
+		return false;
+
+	image.pattern = (SyntheticPattern)pattern;
+	image.width = width;
+	image.height = height;
+	image.scale = scale;
+	image.seed = 1;
+	return true;
+}
+
+template<typename Pixel>
+void generateSyntheticImage(Pixel* buffer, const SyntheticImage& image)
+{
+	int width = image.width, height = image.height;
+	int scale = image.scale > 0 ? image.scale : defaultScale(image.pattern);
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& range) {
+		for (int i = range.begin(); i < range.end(); ++i) {
+			Pixel* row = buffer + (size_t)i * width;
+			switch (image.pattern) {
+			case PATTERN_GRADIENT:
+				for (int j = 0; j < width; ++j)
+					row[j] = (Pixel)(((long long)j * 255 / std::max(width - 1, 1) + (long long)i * 255 / std::max(height - 1, 1)) / 2);
+				break;
+			case PATTERN_CHECKERBOARD:
+				for (int j = 0; j < width; ++j)
+					row[j] = (Pixel)(((j / scale + i / scale) & 1) ? 255 : 0);
+				break;
+			case PATTERN_NOISE:
+				for (int j = 0; j < width; ++j)
+					row[j] = (Pixel)(hashPixel(j, i, image.seed) & 0xFF);
+				break;
+			default:
+				for (int j = 0; j < width; ++j)
+					row[j] = (Pixel)((hashPixel(j / scale, i / scale, image.seed) & 1) ? BRIGHT_BLOCK : DARK_BLOCK);
+				break;
+			}
+		}
+	});
+}
+
+template void generateSyntheticImage<uint8_t>(uint8_t* buffer, const SyntheticImage& image);
+template void generateSyntheticImage<int>(int* buffer, const SyntheticImage& image);
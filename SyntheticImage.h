@@ -0,0 +1,54 @@
+/*
+ * SyntheticImage.h
+ *
+ *  Deterministic generated grayscale test images of any size.
+ */
+
+#ifndef SYNTHETICIMAGE_H_
+#define SYNTHETICIMAGE_H_
+
+/**
+* @brief Content of generated image
+*/
+enum SyntheticPattern {
+	PATTERN_GRADIENT,		// diagonal ramp from black to white, no edges
+	PATTERN_CHECKERBOARD,	// black and white squares of scale pixels
+	PATTERN_NOISE,			// uniform random pixels
+	PATTERN_SPARSE_EDGES,	// random dark or bright blocks of scale pixels, 256 by default
+	PATTERN_DENSE_EDGES		// random dark or bright blocks of scale pixels, 4 by default
+};
+
+/**
+* @brief Generated image description, written as "pattern:WIDTHxHEIGHT[:scale]", for example "noise:4096x4096"
+* or "checkerboard:1024x768:8". Pattern names are gradient, checkerboard, noise, sparse_edges and dense_edges.
+*/
+struct SyntheticImage {
+	SyntheticPattern pattern;
+	int width;
+	int height;
+	int scale;			// size of squares or blocks in pixels, 0 for pattern default
+	unsigned seed;		// random patterns with the same seed are identical
+};
+
+/**
+* @brief Printable name of pattern
+*/
+const char* syntheticPatternName(SyntheticPattern pattern);
+
+/**
+* @brief Parses generated image description
+* @param text description, see SyntheticImage
+* @param image parsed description, seed is set to 1
+* @return false if text is not a valid description, for example a file name
+*/
+bool parseSyntheticImage(const char* text, SyntheticImage& image);
+
+/**
+* @brief Fills buffer with generated grayscale image, rows are generated in parallel. Pixel values are 0 .. 255.
+* @param buffer image.width * image.height pixels
+* @param image what to generate
+*/
+template<typename Pixel>
+void generateSyntheticImage(Pixel* buffer, const SyntheticImage& image);
+
+#endif /* SYNTHETICIMAGE_H_ */
@@ -0,0 +1,119 @@
+/*
+ * Trace.cpp
+ *
+ *  Per thread recording of task and stage intervals, exported as Chrome trace event JSON.
+ *  Recording is compiled in only when ENABLE_TRACING is defined.
+ */
+
+#include "Trace.h"
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// intervals kept per thread, power of two
+#define TRACE_BUFFER_EVENTS		(1 << 16)
+
+namespace {
+
+struct TraceEvent {
+	const char* name;
+	TraceStage stage;
+	int rowStart;
+	int rowEnd;
+	long long start;
+	long long end;
+};
+
+// written only by its thread, read by saveTrace when no traced work runs
+struct ThreadTrace {
+	int thread;
+	unsigned long long recorded;
+	std::vector<TraceEvent> events;
+};
+
+const char* const stageNames[] = { "decode", "convert", "filter", "encode" };
+
+std::mutex& tracesMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+std::vector<std::unique_ptr<ThreadTrace> >& traces()
+{
+	static std::vector<std::unique_ptr<ThreadTrace> > threads;
+	return threads;
+}
+
+ThreadTrace& threadTrace()
+{
+	thread_local ThreadTrace* trace = nullptr;
+	if (trace == nullptr) {
+		std::lock_guard<std::mutex> lock(tracesMutex());
+		traces().push_back(std::unique_ptr<ThreadTrace>(new ThreadTrace()));
+		trace = traces().back().get();
+		trace->thread = (int)traces().size();
+		trace->recorded = 0;
+		trace->events.resize(TRACE_BUFFER_EVENTS);
+	}
+	return *trace;
+}
+
+}
+
+const char* traceStageName(TraceStage stage)
+{
+	return stageNames[stage];
+}
+
+long long traceClock()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceRecord(const char* name, TraceStage stage, int rowStart, int rowEnd, long long start, long long end)
+{
+	ThreadTrace& trace = threadTrace();
+	TraceEvent event = { name, stage, rowStart, rowEnd, start, end };
+	trace.events[trace.recorded++ & (TRACE_BUFFER_EVENTS - 1)] = event;
+}
+
+bool saveTrace(const char* filename)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	std::lock_guard<std::mutex> lock(tracesMutex());
+	long long origin = -1;
+	for (size_t t = 0; t < traces().size(); ++t) {
+		const ThreadTrace& trace = *traces()[t];
+		unsigned long long first = trace.recorded > TRACE_BUFFER_EVENTS ? trace.recorded - TRACE_BUFFER_EVENTS : 0;
+		for (unsigned long long k = first; k < trace.recorded; ++k) {
+			long long start = trace.events[k & (TRACE_BUFFER_EVENTS - 1)].start;
+			if (origin < 0 || start < origin)
+				origin = start;
+		}
+	}
+
+	fprintf(file, "{\"traceEvents\": [\n");
+	bool first = true;
+	for (size_t t = 0; t < traces().size(); ++t) {
+		const ThreadTrace& trace = *traces()[t];
+		fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+			first ? "" : ",\n", trace.thread, trace.thread);
+		first = false;
+
+		unsigned long long oldest = trace.recorded > TRACE_BUFFER_EVENTS ? trace.recorded - TRACE_BUFFER_EVENTS : 0;
+		for (unsigned long long k = oldest; k < trace.recorded; ++k) {
+			const TraceEvent& e = trace.events[k & (TRACE_BUFFER_EVENTS - 1)];
+			fprintf(file, ",\n  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, "
+				"\"args\": {\"rowStart\": %d, \"rowEnd\": %d}}", e.name, stageNames[e.stage], (e.start - origin) / 1000.0,
+				(e.end - e.start) / 1000.0, trace.thread, e.rowStart, e.rowEnd);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
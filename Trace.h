@@ -0,0 +1,72 @@
+/*
+ * Trace.h
+ *
+ *  Per thread recording of task and stage intervals, exported as Chrome trace event JSON.
+ *  Recording is compiled in only when ENABLE_TRACING is defined.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/**
+* @brief Pipeline stage of a recorded interval
+*/
+enum TraceStage {
+	TRACE_DECODE,	// bitmap file to RGB pixels
+	TRACE_CONVERT,	// RGB pixels to grayscale buffer and back
+	TRACE_FILTER,	// filter kernels
+	TRACE_ENCODE	// RGB pixels to bitmap file
+};
+
+/**
+* @brief Printable name of stage
+*/
+const char* traceStageName(TraceStage stage);
+
+/**
+* @brief Monotonic time in nanoseconds used by recorded intervals
+*/
+long long traceClock();
+
+/**
+* @brief Records interval in ring buffer of calling thread, when a buffer is full the oldest intervals are overwritten
+* @param name name of the task, must stay valid until saveTrace, usually a string literal
+* @param stage pipeline stage
+* @param rowStart first processed row
+* @param rowEnd row after the last processed row
+* @param start start time from traceClock
+* @param end end time from traceClock
+*/
+void traceRecord(const char* name, TraceStage stage, int rowStart, int rowEnd, long long start, long long end);
+
+/**
+* @brief Writes recorded intervals of all threads as Chrome trace event JSON (chrome://tracing, Perfetto).
+* Must not be called while traced work is running.
+* @param filename output file name
+* @return false if file can not be written
+*/
+bool saveTrace(const char* filename);
+
+/**
+* @brief Records interval from construction to destruction
+*/
+class TraceScope {
+private:
+	const char* name;
+	TraceStage stage;
+	int rowStart;
+	int rowEnd;
+	long long start;
+public:
+	TraceScope(const char* name, TraceStage stage, int rowStart, int rowEnd) :
+		name(name), stage(stage), rowStart(rowStart), rowEnd(rowEnd), start(traceClock()) {};
+	~TraceScope() { traceRecord(name, stage, rowStart, rowEnd, start, traceClock()); }
+};
+
+#ifdef ENABLE_TRACING
+#define TRACE_SCOPE(name, stage, rowStart, rowEnd)	TraceScope traceScope(name, stage, rowStart, rowEnd)
+#else
+#define TRACE_SCOPE(name, stage, rowStart, rowEnd)
+#endif
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,147 @@
+/*
+ * VariantProfile.cpp
+ *
+ *  Per machine profile of the fastest implementation variant for image size, kernel size and core count.
+ */
+
+#include "VariantProfile.h"
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tbb/tick_count.h>
+
+#define BENCHMARK_RUNS			2
+
+namespace {
+
+struct ProfileKey {
+	std::string algorithm;
+	int sizeBucket;
+	int kernelSize;
+	int cores;
+
+	bool operator<(const ProfileKey& other) const
+	{
+		if (algorithm != other.algorithm)
+			return algorithm < other.algorithm;
+		if (sizeBucket != other.sizeBucket)
+			return sizeBucket < other.sizeBucket;
+		if (kernelSize != other.kernelSize)
+			return kernelSize < other.kernelSize;
+		return cores < other.cores;
+	}
+};
+
+struct ProfileEntry {
+	std::string variant;
+	double seconds;
+};
+
+typedef std::map<ProfileKey, ProfileEntry> Profile;
+
+Profile& profile()
+{
+	static Profile entries;
+	return entries;
+}
+
+std::mutex& profileMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+double benchmark(const Variant& variant)
+{
+	// first run only warms up caches and thread pool
+	variant.run();
+	double best = 0;
+	for (int k = 0; k < BENCHMARK_RUNS; ++k) {
+		auto start = tbb::tick_count::now();
+		variant.run();
+		double seconds = (tbb::tick_count::now() - start).seconds();
+		best = k == 0 ? seconds : std::min(best, seconds);
+	}
+	return best;
+}
+
+}
+
+bool loadVariantProfile(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+		return false;
+
+	std::lock_guard<std::mutex> lock(profileMutex());
+	char algorithm[64], variant[64];
+	int bucket, kernelSize, cores;
+	double seconds;
+	while (fscanf(file, "%63s %d %d %d %63s %lf", algorithm, &bucket, &kernelSize, &cores, variant, &seconds) == 6) {
+		ProfileKey key = { algorithm, bucket, kernelSize, cores };
+		ProfileEntry entry = { variant, seconds };
+		profile()[key] = entry;
+	}
+	fclose(file);
+	return true;
+}
+
+bool saveVariantProfile(const char* filename)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	std::lock_guard<std::mutex> lock(profileMutex());
+	for (Profile::const_iterator it = profile().begin(); it != profile().end(); ++it)
+		fprintf(file, "%s %d %d %d %s %.6g\n", it->first.algorithm.c_str(), it->first.sizeBucket, it->first.kernelSize, it->first.cores,
+			it->second.variant.c_str(), it->second.seconds);
+	return fclose(file) == 0;
+}
+
+int sizeBucket(int width, int height)
+{
+	long long pixels = (long long)width * height;
+	int bits = 0;
+	for (; pixels > 1; pixels >>= 1)
+		++bits;
+	return bits / 2;
+}
+
+int selectVariant(const std::string& algorithm, int width, int height, int kernelSize, int cores, const std::vector<Variant>& variants,
+	bool* measured)
+{
+	ProfileKey key = { algorithm, sizeBucket(width, height), kernelSize, cores };
+	if (measured)
+		*measured = false;
+	if (variants.empty())
+		return -1;
+
+	{
+		std::lock_guard<std::mutex> lock(profileMutex());
+		Profile::const_iterator it = profile().find(key);
+		if (it != profile().end())
+			for (size_t k = 0; k < variants.size(); ++k)
+				if (variants[k].name == it->second.variant)
+					return (int)k;
+	}
+
+	// unknown key, or stored variant is not offered any more
+	int best = 0;
+	double bestSeconds = 0;
+	for (size_t k = 0; k < variants.size(); ++k) {
+		double seconds = benchmark(variants[k]);
+		if (k == 0 || seconds < bestSeconds) {
+			best = (int)k;
+			bestSeconds = seconds;
+		}
+	}
+	if (measured)
+		*measured = true;
+
+	std::lock_guard<std::mutex> lock(profileMutex());
+	ProfileEntry entry = { variants[best].name, bestSeconds };
+	profile()[key] = entry;
+	return best;
+}
@@ -0,0 +1,57 @@
+/*
+ * VariantProfile.h
+ *
+ *  Per machine profile of the fastest implementation variant for image size, kernel size and core count.
+ */
+
+#ifndef VARIANTPROFILE_H_
+#define VARIANTPROFILE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+* @brief Implementation variant, run processes the whole image
+*/
+struct Variant {
+	std::string name;
+	std::function<void()> run;
+};
+
+/**
+* @brief Loads profile file, lines are "algorithm sizeBucket kernelSize cores variant seconds"
+* @param filename profile file name
+* @return false if file can not be read
+*/
+bool loadVariantProfile(const char* filename);
+
+/**
+* @brief Saves profile file
+* @param filename profile file name
+* @return false if file can not be written
+*/
+bool saveVariantProfile(const char* filename);
+
+/**
+* @brief Images whose pixel counts are within a factor of 4 share a bucket
+*/
+int sizeBucket(int width, int height);
+
+/**
+* @brief Chooses the fastest variant for the image from the profile. If the profile has no entry for this
+* algorithm, size bucket, kernel size and core count, every variant is timed on the image (best of a few
+* runs after a warm up run) and the winner is stored in the profile.
+* @param algorithm name of the algorithm
+* @param width image width
+* @param height image height
+* @param kernelSize size of the filter or lookup window
+* @param cores number of worker threads
+* @param variants candidate variants, all of them compute the same output
+* @param measured set to true if variants were timed
+* @return index of the chosen variant, -1 if there are no variants
+*/
+int selectVariant(const std::string& algorithm, int width, int height, int kernelSize, int cores, const std::vector<Variant>& variants,
+	bool* measured = nullptr);
+
+#endif /* VARIANTPROFILE_H_ */
@@ -1,39 +1,110 @@
 #include <iostream>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
 #include "BitmapRawConverter.h"
+#include "SeparableFilter.h"
+#include "StaticPrewitt.h"
+#include "SimdPrewitt.h"
+#include "SlidingWindowEdges.h"
+#include "BinaryEdges.h"
+#include "PaddedImage.h"
+#include "FusedPrewitt.h"
+#include "CacheTiling.h"
+#include "CutOffModel.h"
+#include "VariantProfile.h"
+#include "IntegralEdges.h"
+#include "ParallelBackend.h"
+#include "ScalingStudy.h"
+#include "BenchmarkHarness.h"
+#include "SyntheticImage.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "MappedBitmap.h"
+#include "BitmapRows.h"
 #include <tbb/task_group.h>
 #include <tbb/tick_count.h>
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/task_arena.h>
 
 #define __ARG_NUM__				10
 #define THRESHOLD				128
 #define CUT_OFF					2000
+#define SPLIT_LONGER_DIMENSION	true
+#define COLUMN_SPLIT_STEP		64
+#define CALIBRATION_FILE		"cutoff_calibration.txt"
+#define CALIBRATION_WIDTH		1024
+#define CALIBRATION_HEIGHT		64
+#define PROFILE_FILE			"variant_profile.txt"
+#define SCALING_OPTION			"--scaling"
+#define STAGES_OPTION			"--stages"
+#define STREAM_OPTION			"--stream"
+#define STREAM_BAND_BYTES		(4 << 20)
+#define STAGE_BITMAP_FILE		"stage_benchmark.bmp"
+#define TRACE_FILE				"trace.json"
+#define BENCHMARK_WARMUP		1
+#define BENCHMARK_REPETITIONS	5
+#define BENCHMARK_FILE			"benchmark_results.csv"
+#define SLIDING_WINDOW_MIN_WIDTH	512
+#define SWEEP_LOOKUP_WIDTHS		{ 3, 5, 7 }
 
 using namespace std;
 
+// grayscale image and filter output pixel type
+typedef uint8_t Pixel;
+
+// implementations of edge detection algorithm
+enum EdgeEngine {
+	EDGE_WINDOW_SCAN,		// whole lookup window is scanned for every pixel, reference for the others
+	EDGE_SLIDING_WINDOW,	// running window minimum/maximum
+	EDGE_BIT_PACKED,		// thresholded image packed 64 pixels per word
+	EDGE_FASTEST			// bit-packed, or sliding window from SLIDING_WINDOW_MIN_WIDTH on
+};
+
+// implementations of Prewitt operator
+enum PrewittEngine {
+	PREWITT_DIRECT,			// whole filter window is convolved for every pixel, reference for the others
+	PREWITT_SEPARABLE,		// filters written as sums of separable terms
+	PREWITT_STATIC,			// filters known at compile time
+	PREWITT_SIMD,			// several pixels per instruction
+	PREWITT_FASTEST			// first available of SIMD, static and separable
+};
+
+/**
+* @brief Edge detection engine used for EDGE_FASTEST. Bit-packed cost grows with lookup width (vertical pass ORs
+* lookupWidth rows), sliding window cost does not, they are about equal at 512.
+*/
+inline EdgeEngine fastestEdgeEngine(int lookupWidth)
+{
+	return lookupWidth >= SLIDING_WINDOW_MIN_WIDTH ? EDGE_SLIDING_WINDOW : EDGE_BIT_PACKED;
+}
+
 // Prewitt operators
-int filterHor3[3 * 3] = {-1, 0, 1, -1, 0, 1, -1, 0, 1};
-int filterVer3[3 * 3] = {-1, -1, -1, 0, 0, 0, 1, 1, 1};
+constexpr int filterHor3[3 * 3] = {-1, 0, 1, -1, 0, 1, -1, 0, 1};
+constexpr int filterVer3[3 * 3] = {-1, -1, -1, 0, 0, 0, 1, 1, 1};
 
-int filterHor5[5 * 5] = {9, 9, 9, 9, 9,
+constexpr int filterHor5[5 * 5] = {9, 9, 9, 9, 9,
 						9, 5, 5, 5, 9,
 						-7, -3, 0, -3, -7,
 						-7, -3, -3, -3, -7,
 						-7, -7, -7, -7, -7, };
-int filterVer5[5 * 5] = { 9, 9, -7, -7, -7,
+constexpr int filterVer5[5 * 5] = { 9, 9, -7, -7, -7,
 						9, 5, -3, -3, -7,
 						9, 5, 0, -3, -7,
 						9, 5, -3, -3, -7,
 						9, 9, -7, -7, -7
 						};
 
-int filterHor7[7 * 7] = {-3, -2, -1, 0, 1, 2, 3,
+constexpr int filterHor7[7 * 7] = {-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3, };
-int filterVer7[7 * 7] = { -3, -2, -1, 0, 1, 2, 3,
+constexpr int filterVer7[7 * 7] = { -3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
 						-3, -2, -1, 0, 1, 2, 3,
@@ -51,7 +122,8 @@ int filterVer7[7 * 7] = { -3, -2, -1, 0, 1, 2, 3,
 * @param filterHor horizontal component filter
 * @param filterSize size of the filter
 */
-int prewitt(int pixelRow, int pixelColumn, int* inBuffer, int* outBuffer, int width, int* filterVer, int* filterHor,
+template<typename InPixel, typename OutPixel>
+int prewitt(int pixelRow, int pixelColumn, InPixel* inBuffer, OutPixel* outBuffer, int width, const int* filterVer, const int* filterHor,
 	int filterSize) {
 	int pixelRowStart = pixelRow - (filterSize / 2);
 	int pixelColumnStart = pixelColumn - (filterSize / 2);
@@ -74,7 +146,8 @@ int prewitt(int pixelRow, int pixelColumn, int* inBuffer, int* outBuffer, int wi
 * @param width image width
 * @param lookupWidth size of neighbour lookup matrix
 */
-int detectEdges(int pixelRowStart, int pixelColumnStart, int* inBuffer, int* outBuffer, int width, int lookupWidth) {
+template<typename InPixel, typename OutPixel>
+int detectEdges(int pixelRowStart, int pixelColumnStart, InPixel* inBuffer, OutPixel* outBuffer, int width, int lookupWidth) {
 	int P = 0, O = 1;
 	for (int i = 0; i < lookupWidth; ++i) {
 		for (int j = 0; j < lookupWidth; ++j) {
@@ -99,26 +172,96 @@ int detectEdges(int pixelRowStart, int pixelColumnStart, int* inBuffer, int* out
 * @param filterSize size of the filter
 * @param rowStart from where does row processing start
 * @param rowEnd where does row processing end
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
+* @param engine implementation of the operator, falls back to direct convolution when it is not available
 */
-void filter_serial_prewitt(int *inBuffer, int *outBuffer, int width, int height, int* filterVer, int* filterHor,
-	int filterSize, int rowStart=0, int rowEnd=-1)
+template<typename InPixel, typename OutPixel>
+void filter_serial_prewitt(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart=0, int rowEnd=-1, PrewittRows<InPixel, OutPixel> specialized=nullptr,
+	const PaddedImage<InPixel>* padded=nullptr, PrewittEngine engine=PREWITT_DIRECT)
 {
 	int offset = filterSize / 2;
 	if (rowEnd == -1)
-		rowEnd = height - offset;
-	
+		rowEnd = padded ? height : height - offset;
+
+	if (padded) {
+		filter_padded_prewitt(*padded, outBuffer, filterVer, filterHor, filterSize, rowStart, rowEnd);
+		return;
+	}
+	if ((engine == PREWITT_SIMD || engine == PREWITT_FASTEST) && detectSimdLevel() != SIMD_SCALAR) {
+		filter_simd_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd);
+		return;
+	}
+	if ((engine == PREWITT_STATIC || engine == PREWITT_FASTEST) && specialized) {
+		specialized(inBuffer, outBuffer, width, height, rowStart, rowEnd);
+		return;
+	}
+
+	if (engine == PREWITT_SEPARABLE || engine == PREWITT_FASTEST) {
+		const KernelDecomposition* separableVer = findKernelDecomposition(filterVer, filterSize);
+		const KernelDecomposition* separableHor = findKernelDecomposition(filterHor, filterSize);
+		if (separableVer && separableHor) {
+			filter_separable_prewitt(inBuffer, outBuffer, width, height, *separableVer, *separableHor, rowStart, rowEnd);
+			return;
+		}
+	}
+
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
 	for (int i = rowStart; i < rowEnd; ++i) {
 		for (int j = offset; j < width - offset; ++j) {
-			if (i < filterSize / 2 || i > height - filterSize / 2)
-				continue;
 			outBuffer[i * width + j] = prewitt(i, j, inBuffer, outBuffer, width, filterVer, filterHor, filterSize) >= 128 ? 255 : 0;
 		}
 	}
 }
 
 
+// names of measured costs used by task based versions
+inline const char* prewittCostKey(bool padded) { return padded ? "prewitt_padded" : "prewitt"; }
+inline const char* edgeCostKey(bool padded) { return padded ? "edge_padded" : "edge"; }
+
+/**
+* @brief Task recursion of parallel Prewitt version over rows rowStart .. rowEnd - 1 and columns columnStart .. columnEnd - 1.
+* Region is halved along its longer side until it has less than leafPixels pixels. Columns are split only when
+* kernel can process part of a row (vectorized or padded), otherwise rows are split.
+*/
+template<typename InPixel, typename OutPixel>
+void parallel_prewitt_region(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, int rowStart, int rowEnd, int columnStart, int columnEnd, long leafPixels, PrewittRows<InPixel, OutPixel> specialized,
+	const PaddedImage<InPixel>* padded)
+{
+	int rows = rowEnd - rowStart, columns = columnEnd - columnStart;
+	bool splitColumns = SPLIT_LONGER_DIMENSION && columns > rows && columns >= 2 * COLUMN_SPLIT_STEP
+		&& (padded || detectSimdLevel() != SIMD_SCALAR);
+	if ((long)rows * columns < leafPixels || (rows < 2 && !splitColumns)) {
+		TRACE_SCOPE("prewitt task", TRACE_FILTER, rowStart, rowEnd);
+		if (columnStart == 0 && columnEnd == width)
+			filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, specialized, padded,
+				PREWITT_FASTEST);
+		else if (padded)
+			filter_padded_prewitt(*padded, outBuffer, filterVer, filterHor, filterSize, rowStart, rowEnd, columnStart, columnEnd);
+		else
+			filter_simd_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, columnStart, columnEnd);
+		return;
+	}
+
+	tbb::task_group tg;
+	if (splitColumns) {
+		int middle = columnStart + columns / 2 / COLUMN_SPLIT_STEP * COLUMN_SPLIT_STEP;
+		tg.run([=]() {parallel_prewitt_region(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, columnStart, middle, leafPixels, specialized, padded); });
+		tg.run([=]() {parallel_prewitt_region(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, middle, columnEnd, leafPixels, specialized, padded); });
+	}
+	else {
+		tg.run([=]() {parallel_prewitt_region(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, (rowStart + rowEnd) / 2, columnStart, columnEnd, leafPixels, specialized, padded); });
+		tg.run([=]() {parallel_prewitt_region(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, (rowStart + rowEnd) / 2, rowEnd, columnStart, columnEnd, leafPixels, specialized, padded); });
+	}
+	tg.wait();
+}
+
 /**
-* @brief Parallel version of edge detection algorithm implementation using Prewitt operator
+* @brief Parallel version of edge detection algorithm implementation using Prewitt operator. Work is split
+* until tasks get the number of pixels given by calibrated cost model (CUT_OFF rows if it is not calibrated).
 * 
 * @param inBuffer buffer of input image
 * @param outBuffer buffer of output image
@@ -129,21 +272,21 @@ void filter_serial_prewitt(int *inBuffer, int *outBuffer, int width, int height,
 * @param filterSize size of the filter
 * @param rowStart from where does row processing start
 * @param rowEnd where does row processing end
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
 */
-void filter_parallel_prewitt(int *inBuffer, int *outBuffer, int width, int height, int* filterVer, int* filterHor, int filterSize,
-	int rowStart=0, int rowEnd=-1)
+template<typename InPixel, typename OutPixel>
+void filter_parallel_prewitt(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, const int* filterVer, const int* filterHor, int filterSize,
+	int rowStart=0, int rowEnd=-1, PrewittRows<InPixel, OutPixel> specialized=nullptr, const PaddedImage<InPixel>* padded=nullptr)
 {	
 	if (rowEnd == -1)
-		rowEnd = height - filterSize / 2;
-	if ((rowEnd - rowStart) < CUT_OFF) {
-		filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd);
-	}
-	else {
-		tbb::task_group tg;
-		tg.run([=]() {filter_parallel_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, (rowStart + rowEnd) / 2); });
-		tg.run([=]() {filter_parallel_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, (rowStart + rowEnd) / 2, rowEnd); });
-		tg.wait();
-	}
+		rowEnd = padded ? height : height - filterSize / 2;
+	long leaf = leafPixels(pixelCost(prewittCostKey(padded != nullptr), filterSize), (long)(rowEnd - rowStart) * width,
+		tbb::this_task_arena::max_concurrency());
+	if (leaf < 0)
+		leaf = (long)CUT_OFF * width;
+	parallel_prewitt_region(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, 0, width, leaf,
+		specialized, padded);
 }
 
 /**
@@ -155,24 +298,77 @@ void filter_parallel_prewitt(int *inBuffer, int *outBuffer, int width, int heigh
 * @param lookupWidth size of neighbour lookup matrix
 * @param rowStart from where does row processing start
 * @param rowEnd where does row processing end
+* @param engine implementation of the algorithm, whole window scan by default
+* @param padded padded copy of input image, when given border pixels are computed too
 */
-void filter_serial_edge_detection(int *inBuffer, int *outBuffer, int width, int height, int lookupWidth, int rowStart=0, int rowEnd=-1)
+template<typename InPixel, typename OutPixel>
+void filter_serial_edge_detection(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, int lookupWidth, int rowStart=0, int rowEnd=-1,
+	EdgeEngine engine=EDGE_WINDOW_SCAN, const PaddedImage<InPixel>* padded=nullptr)
 {
 	int offset = lookupWidth / 2;
 	if (rowEnd == -1)
-		rowEnd = height - offset;
+		rowEnd = padded ? height : height - offset;
+	if (engine == EDGE_FASTEST)
+		engine = fastestEdgeEngine(lookupWidth);
+
+	if (padded) {
+		filter_padded_edge_detection(*padded, outBuffer, lookupWidth, rowStart, rowEnd);
+		return;
+	}
+	if (engine == EDGE_BIT_PACKED) {
+		filter_binary_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd);
+		return;
+	}
+	if (engine == EDGE_SLIDING_WINDOW) {
+		filter_sliding_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd);
+		return;
+	}
 
+	rowStart = std::max(rowStart, offset);
+	rowEnd = std::min(rowEnd, height - offset);
 	for (int i = rowStart; i < rowEnd; ++i) {
 		for (int j = offset; j < width - offset; ++j) {
-			if (i < lookupWidth / 2 || i > height - lookupWidth / 2)
-				continue;
 			outBuffer[i * width + j] = detectEdges(i - offset, j - offset, inBuffer, outBuffer, width, lookupWidth) ? 255 : 0;
 		}
 	}
 }
 
 /**
-* @brief Parallel version of edge detection algorithm
+* @brief Task recursion of parallel edge detection version over rows rowStart .. rowEnd - 1 and columns columnStart .. columnEnd - 1.
+* Region is halved along its longer side until it has less than leafPixels pixels. Packed rows span whole image
+* width, so columns are split only for padded image.
+*/
+template<typename InPixel, typename OutPixel>
+void parallel_edge_region(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, int lookupWidth, int rowStart, int rowEnd,
+	int columnStart, int columnEnd, long leafPixels, const PaddedImage<InPixel>* padded)
+{
+	int rows = rowEnd - rowStart, columns = columnEnd - columnStart;
+	bool splitColumns = SPLIT_LONGER_DIMENSION && columns > rows && columns >= 2 * COLUMN_SPLIT_STEP && padded;
+	if ((long)rows * columns < leafPixels || (rows < 2 && !splitColumns)) {
+		TRACE_SCOPE("edge task", TRACE_FILTER, rowStart, rowEnd);
+		if (columnStart == 0 && columnEnd == width)
+			filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, EDGE_FASTEST, padded);
+		else
+			filter_padded_edge_detection(*padded, outBuffer, lookupWidth, rowStart, rowEnd, columnStart, columnEnd);
+		return;
+	}
+
+	tbb::task_group tg;
+	if (splitColumns) {
+		int middle = columnStart + columns / 2 / COLUMN_SPLIT_STEP * COLUMN_SPLIT_STEP;
+		tg.run([=]() {parallel_edge_region(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, columnStart, middle, leafPixels, padded); });
+		tg.run([=]() {parallel_edge_region(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, middle, columnEnd, leafPixels, padded); });
+	}
+	else {
+		tg.run([=]() {parallel_edge_region(inBuffer, outBuffer, width, height, lookupWidth, rowStart, (rowStart + rowEnd) / 2, columnStart, columnEnd, leafPixels, padded); });
+		tg.run([=]() {parallel_edge_region(inBuffer, outBuffer, width, height, lookupWidth, (rowStart + rowEnd) / 2, rowEnd, columnStart, columnEnd, leafPixels, padded); });
+	}
+	tg.wait();
+}
+
+/**
+* @brief Parallel version of edge detection algorithm. Work is split until tasks get the number of pixels
+* given by calibrated cost model (CUT_OFF rows if it is not calibrated).
 * 
 * @param inBuffer buffer of input image
 * @param outBuffer buffer of output image
@@ -184,20 +380,19 @@ void filter_serial_edge_detection(int *inBuffer, int *outBuffer, int width, int
 * @param filterSize size of the filter
 * @param rowStart from where does row processing start
 * @param rowEnd where does row processing end
+* @param padded padded copy of input image, when given border pixels are computed too
 */
-void filter_parallel_edge_detection(int *inBuffer, int *outBuffer, int width, int height, int lookupWidth, int rowStart=0, int rowEnd=-1)
+template<typename InPixel, typename OutPixel>
+void filter_parallel_edge_detection(InPixel *inBuffer, OutPixel *outBuffer, int width, int height, int lookupWidth, int rowStart=0, int rowEnd=-1,
+	const PaddedImage<InPixel>* padded=nullptr)
 {
 	if (rowEnd == -1)
-		rowEnd = height - lookupWidth / 2;
-	if ((rowEnd - rowStart) < CUT_OFF) {
-		filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd);
-	}
-	else {
-		tbb::task_group tg;
-		tg.run([=]() {filter_parallel_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, (rowStart + rowEnd) / 2); });
-		tg.run([=]() {filter_parallel_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, (rowStart + rowEnd) / 2, rowEnd); });
-		tg.wait();
-	}
+		rowEnd = padded ? height : height - lookupWidth / 2;
+	long leaf = leafPixels(pixelCost(edgeCostKey(padded != nullptr), lookupWidth), (long)(rowEnd - rowStart) * width,
+		tbb::this_task_arena::max_concurrency());
+	if (leaf < 0)
+		leaf = (long)CUT_OFF * width;
+	parallel_edge_region(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, 0, width, leaf, padded);
 }
 
 /**
@@ -210,25 +405,74 @@ void filter_parallel_edge_detection(int *inBuffer, int *outBuffer, int width, in
 * @param filterVer vertical component filter
 * @param filterHor horizontal component filter
 * @param filterSize size of the filter
+* @param separableVer separable terms of vertical filter, nullptr if it can not be decomposed
+* @param separableHor separable terms of horizontal filter, nullptr if it can not be decomposed
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, nullptr if border pixels are not computed
 */
 
+template<typename InPixel, typename OutPixel>
 struct ApplyPrewitt {
-	int* inBuffer;
-	int* outBuffer;
+	InPixel* inBuffer;
+	OutPixel* outBuffer;
 	int width;
 	int height;
-	int* filterVer;
-	int* filterHor;
+	const int* filterVer;
+	const int* filterHor;
 	int filterSize;
-	ApplyPrewitt(int* inBuffer, int* outBuffer, int width, int height, int* filterVer, int* filterHor, int filterSize) : inBuffer(inBuffer),
-		outBuffer(outBuffer), width(width), height(height), filterHor(filterHor), filterVer(filterVer), filterSize(filterSize) {};
+	const KernelDecomposition* separableVer;
+	const KernelDecomposition* separableHor;
+	PrewittRows<InPixel, OutPixel> specialized;
+	const PaddedImage<InPixel>* padded;
+	ApplyPrewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor, int filterSize,
+		const KernelDecomposition* separableVer = nullptr, const KernelDecomposition* separableHor = nullptr,
+		PrewittRows<InPixel, OutPixel> specialized = nullptr, const PaddedImage<InPixel>* padded = nullptr) : inBuffer(inBuffer),
+		outBuffer(outBuffer), width(width), height(height), filterVer(filterVer), filterHor(filterHor), filterSize(filterSize),
+		separableVer(separableVer), separableHor(separableHor), specialized(specialized), padded(padded) {};
 	void operator()(const tbb::blocked_range<int> range) const{
+		TRACE_SCOPE("prewitt chunk", TRACE_FILTER, range.begin(), range.end());
+		if (padded) {
+			filter_padded_prewitt(*padded, outBuffer, filterVer, filterHor, filterSize, range.begin(), range.end());
+			return;
+		}
+		if (detectSimdLevel() != SIMD_SCALAR) {
+			filter_simd_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, range.begin(), range.end());
+			return;
+		}
+		if (specialized) {
+			specialized(inBuffer, outBuffer, width, height, range.begin(), range.end());
+			return;
+		}
+		if (separableVer && separableHor) {
+			filter_separable_prewitt(inBuffer, outBuffer, width, height, *separableVer, *separableHor, range.begin(), range.end());
+			return;
+		}
+
 		int offset = filterSize / 2;
+		int rowStart = std::max(range.begin(), offset);
+		int rowEnd = std::min(range.end(), height - offset);
 
-		for (int i = range.begin(); i < range.end(); ++i) {
+		for (int i = rowStart; i < rowEnd; ++i) {
 			for (int j = offset; j < width - offset; ++j) {
-				if (i < filterSize / 2 || i > height - filterSize / 2)
-					continue;
+				outBuffer[i * width + j] = prewitt(i, j, inBuffer, outBuffer, width, filterVer, filterHor, filterSize) >= 128 ? 255 : 0;
+			}
+		}
+	}
+	void operator()(const tbb::blocked_range2d<int> tile) const {
+		int rowStart = tile.rows().begin(), rowEnd = tile.rows().end();
+		int columnStart = tile.cols().begin(), columnEnd = tile.cols().end();
+		TRACE_SCOPE("prewitt tile", TRACE_FILTER, rowStart, rowEnd);
+		if (padded) {
+			filter_padded_prewitt(*padded, outBuffer, filterVer, filterHor, filterSize, rowStart, rowEnd, columnStart, columnEnd);
+			return;
+		}
+		if (detectSimdLevel() != SIMD_SCALAR) {
+			filter_simd_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, rowStart, rowEnd, columnStart, columnEnd);
+			return;
+		}
+
+		for (int i = rowStart; i < rowEnd; ++i) {
+			for (int j = columnStart; j < columnEnd; ++j) {
 				outBuffer[i * width + j] = prewitt(i, j, inBuffer, outBuffer, width, filterVer, filterHor, filterSize) >= 128 ? 255 : 0;
 			}
 		}
@@ -246,12 +490,16 @@ struct ApplyPrewitt {
 * @param filterHor horizontal component filter
 * @param filterSize size of the filter
 * @param affinity should it use affinity toward cache memory or no
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
 */
-void filter_parallel_for_prewitt(int* inBuffer, int* outBuffer, int width, int height, int* filterVer, int* filterHor,
-	int filterSize, bool affinity = false)
+template<typename InPixel, typename OutPixel>
+void filter_parallel_for_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, bool affinity = false, PrewittRows<InPixel, OutPixel> specialized = nullptr, const PaddedImage<InPixel>* padded = nullptr)
 {
-	int rowStart = 0, rowEnd = height - filterSize / 2;
-	ApplyPrewitt ap(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize);
+	int rowStart = 0, rowEnd = padded ? height : height - filterSize / 2;
+	ApplyPrewitt<InPixel, OutPixel> ap(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize,
+		findKernelDecomposition(filterVer, filterSize), findKernelDecomposition(filterHor, filterSize), specialized, padded);
 	if (affinity) {
 		static tbb::affinity_partitioner affinityPartitioner;
 		tbb::parallel_for(tbb::blocked_range<int>(rowStart, rowEnd), ap, affinityPartitioner);
@@ -269,22 +517,64 @@ void filter_parallel_for_prewitt(int* inBuffer, int* outBuffer, int width, int h
 * @param width image width
 * @param height image height
 * @param lookupWidth size of neighbour lookup matrix
+* @param engine implementation of the algorithm
+* @param padded padded copy of input image, nullptr if border pixels are not computed
 */
 
+template<typename InPixel, typename OutPixel>
 struct ApplyEdge {
-	int* inBuffer;
-	int* outBuffer;
+	InPixel* inBuffer;
+	OutPixel* outBuffer;
 	int width;
 	int height;
 	int lookupWidth;
-	ApplyEdge(int* inBuffer, int* outBuffer, int width, int height, int lookupWidth) :
-		inBuffer(inBuffer), outBuffer(outBuffer), width(width), height(height), lookupWidth(lookupWidth) {};
+	EdgeEngine engine;
+	const PaddedImage<InPixel>* padded;
+	ApplyEdge(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth, EdgeEngine engine = EDGE_FASTEST,
+		const PaddedImage<InPixel>* padded = nullptr) :
+		inBuffer(inBuffer), outBuffer(outBuffer), width(width), height(height), lookupWidth(lookupWidth), engine(engine), padded(padded) {};
 	void operator()(const tbb::blocked_range<int> range) const {
+		TRACE_SCOPE("edge chunk", TRACE_FILTER, range.begin(), range.end());
+		if (padded) {
+			filter_padded_edge_detection(*padded, outBuffer, lookupWidth, range.begin(), range.end());
+			return;
+		}
+		EdgeEngine engine = this->engine == EDGE_FASTEST ? fastestEdgeEngine(lookupWidth) : this->engine;
+		if (engine == EDGE_BIT_PACKED) {
+			filter_binary_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, range.begin(), range.end());
+			return;
+		}
+		if (engine == EDGE_SLIDING_WINDOW) {
+			filter_sliding_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, range.begin(), range.end());
+			return;
+		}
+
 		int offset = lookupWidth / 2;
-		for (int i = range.begin(); i < range.end(); ++i) {
+		int rowStart = std::max(range.begin(), offset);
+		int rowEnd = std::min(range.end(), height - offset);
+		for (int i = rowStart; i < rowEnd; ++i) {
 			for (int j = offset; j < width - offset; ++j) {
-				if (i < lookupWidth / 2 || i > height - lookupWidth / 2)
-					continue;
+				outBuffer[i * width + j] = detectEdges(i - offset, j - offset, inBuffer, outBuffer, width, lookupWidth) ? 255 : 0;
+			}
+		}
+	}
+	// packed rows span whole image width, so tiles use running window unless window scan is requested
+	void operator()(const tbb::blocked_range2d<int> tile) const {
+		int rowStart = tile.rows().begin(), rowEnd = tile.rows().end();
+		int columnStart = tile.cols().begin(), columnEnd = tile.cols().end();
+		TRACE_SCOPE("edge tile", TRACE_FILTER, rowStart, rowEnd);
+		if (padded) {
+			filter_padded_edge_detection(*padded, outBuffer, lookupWidth, rowStart, rowEnd, columnStart, columnEnd);
+			return;
+		}
+		if (engine != EDGE_WINDOW_SCAN) {
+			filter_sliding_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, rowStart, rowEnd, columnStart, columnEnd);
+			return;
+		}
+
+		int offset = lookupWidth / 2;
+		for (int i = rowStart; i < rowEnd; ++i) {
+			for (int j = columnStart; j < columnEnd; ++j) {
 				outBuffer[i * width + j] = detectEdges(i - offset, j - offset, inBuffer, outBuffer, width, lookupWidth) ? 255 : 0;
 			}
 		}
@@ -300,12 +590,15 @@ struct ApplyEdge {
 * @param height image height
 * @param lookupWidth size of neighbour lookup matrix
 * @param affinity should it use affinity toward cache memory or no
+* @param padded padded copy of input image, when given border pixels are computed too
 */
 
-void filter_parallel_for_edge_detection(int* inBuffer, int* outBuffer, int width, int height, int lookupWidth, bool affinity = false)
+template<typename InPixel, typename OutPixel>
+void filter_parallel_for_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth, bool affinity = false,
+	const PaddedImage<InPixel>* padded = nullptr)
 {
-	int rowStart = 0, rowEnd = height - lookupWidth / 2;
-	ApplyEdge ae(inBuffer, outBuffer, width, height, lookupWidth);
+	int rowStart = 0, rowEnd = padded ? height : height - lookupWidth / 2;
+	ApplyEdge<InPixel, OutPixel> ae(inBuffer, outBuffer, width, height, lookupWidth, EDGE_FASTEST, padded);
 	if (affinity) {
 		static tbb::affinity_partitioner affinityPartitioner;
 		tbb::parallel_for(tbb::blocked_range<int>(rowStart, rowEnd), ae, affinityPartitioner);
@@ -314,153 +607,524 @@ void filter_parallel_for_edge_detection(int* inBuffer, int* outBuffer, int width
 		tbb::parallel_for(tbb::blocked_range<int>(rowStart, rowEnd), ae, tbb::auto_partitioner());
 }
 
+/**
+* @brief Tiled version of edge detection algorithm implementation using Prewitt operator, image is split
+* into 2D tiles of at most given shape
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param tile tile shape, see chooseTileShape
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+void filter_tiled_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, TileShape tile, const PaddedImage<InPixel>* padded = nullptr)
+{
+	int offset = padded ? 0 : filterSize / 2;
+	if (height - offset <= offset || width - offset <= offset)
+		return;
+	ApplyPrewitt<InPixel, OutPixel> ap(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, nullptr, nullptr, nullptr, padded);
+	tbb::parallel_for(tbb::blocked_range2d<int>(offset, height - offset, tile.rows, offset, width - offset, tile.columns), ap,
+		tbb::simple_partitioner());
+}
+
+/**
+* @brief Tiled version of edge detection algorithm implementation, image is split into 2D tiles of at most given shape
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param tile tile shape, see chooseTileShape
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+void filter_tiled_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth, TileShape tile,
+	const PaddedImage<InPixel>* padded = nullptr)
+{
+	int offset = padded ? 0 : lookupWidth / 2;
+	if (height - offset <= offset || width - offset <= offset)
+		return;
+	ApplyEdge<InPixel, OutPixel> ae(inBuffer, outBuffer, width, height, lookupWidth, EDGE_FASTEST, padded);
+	tbb::parallel_for(tbb::blocked_range2d<int>(offset, height - offset, tile.rows, offset, width - offset, tile.columns), ae,
+		tbb::simple_partitioner());
+}
+
+/**
+* @brief Version of edge detection algorithm implementation using Prewitt operator that splits rows on chosen
+* threading library, see parallelRows
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param backend threading library
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+void filter_backend_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, ParallelBackend backend, PrewittRows<InPixel, OutPixel> specialized = nullptr, const PaddedImage<InPixel>* padded = nullptr)
+{
+	int rowStart = 0, rowEnd = padded ? height : height - filterSize / 2;
+	ApplyPrewitt<InPixel, OutPixel> ap(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize,
+		findKernelDecomposition(filterVer, filterSize), findKernelDecomposition(filterHor, filterSize), specialized, padded);
+	parallelRows(backend, rowStart, rowEnd, 0, [&](int rangeStart, int rangeEnd) {
+		ap(tbb::blocked_range<int>(rangeStart, rangeEnd));
+	});
+}
+
+/**
+* @brief Version of edge detection algorithm implementation that splits rows on chosen threading library, see parallelRows
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param backend threading library
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+void filter_backend_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth, ParallelBackend backend,
+	const PaddedImage<InPixel>* padded = nullptr)
+{
+	int rowStart = 0, rowEnd = padded ? height : height - lookupWidth / 2;
+	ApplyEdge<InPixel, OutPixel> ae(inBuffer, outBuffer, width, height, lookupWidth, EDGE_FASTEST, padded);
+	parallelRows(backend, rowStart, rowEnd, 0, [&](int rangeStart, int rangeEnd) {
+		ae(tbb::blocked_range<int>(rangeStart, rangeEnd));
+	});
+}
+
+/**
+* @brief TBB based variants of edge detection using Prewitt operator: task, parallel for, parallel for with affinity and tiled
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+vector<Variant> prewitt_tbb_variants(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, PrewittRows<InPixel, OutPixel> specialized = nullptr, const PaddedImage<InPixel>* padded = nullptr)
+{
+	vector<Variant> variants;
+	variants.push_back({ "task", [=]() { filter_parallel_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded); } });
+	variants.push_back({ "for", [=]() { filter_parallel_for_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, false, specialized, padded); } });
+	variants.push_back({ "for_affinity", [=]() { filter_parallel_for_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, true, specialized, padded); } });
+	TileShape tile = chooseTileShape(width, height, filterSize, sizeof(InPixel), sizeof(OutPixel));
+	variants.push_back({ "tiled", [=]() { filter_tiled_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, tile, padded); } });
+	return variants;
+}
+
+/**
+* @brief TBB based variants of edge detection: task, parallel for, parallel for with affinity and tiled
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param padded padded copy of input image, when given border pixels are computed too
+*/
+template<typename InPixel, typename OutPixel>
+vector<Variant> edge_tbb_variants(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	const PaddedImage<InPixel>* padded = nullptr)
+{
+	vector<Variant> variants;
+	variants.push_back({ "task", [=]() { filter_parallel_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, padded); } });
+	variants.push_back({ "for", [=]() { filter_parallel_for_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, false, padded); } });
+	variants.push_back({ "for_affinity", [=]() { filter_parallel_for_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, true, padded); } });
+	TileShape tile = chooseTileShape(width, height, lookupWidth, sizeof(InPixel), sizeof(OutPixel));
+	variants.push_back({ "tiled", [=]() { filter_tiled_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, tile, padded); } });
+	return variants;
+}
 
+/**
+* @brief Edge detection using Prewitt operator with the variant that is fastest on this machine for images of this
+* size, see selectVariant. Variants are serial, task, parallel for, parallel for with affinity and tiled, and for images
+* without padding also specialized, separable and every supported instruction set.
+*
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param specialized implementation specialized for given filters, nullptr if there is none
+* @param padded padded copy of input image, when given border pixels are computed too
+* @param measured set to true if variants were timed to choose
+* @return name of the chosen variant
+*/
+template<typename InPixel, typename OutPixel>
+string filter_auto_prewitt(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, const int* filterVer, const int* filterHor,
+	int filterSize, PrewittRows<InPixel, OutPixel> specialized = nullptr, const PaddedImage<InPixel>* padded = nullptr, bool* measured = nullptr)
+{
+	vector<Variant> variants(1, Variant{ "serial", [=]() {
+		filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded, PREWITT_FASTEST); } });
+	vector<Variant> parallel = prewitt_tbb_variants(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, specialized, padded);
+	variants.insert(variants.end(), parallel.begin(), parallel.end());
+
+	if (!padded) {
+		if (specialized)
+			variants.push_back({ "static", [=]() { specialized(inBuffer, outBuffer, width, height, 0, height); } });
+		const KernelDecomposition* separableVer = findKernelDecomposition(filterVer, filterSize);
+		const KernelDecomposition* separableHor = findKernelDecomposition(filterHor, filterSize);
+		if (separableVer && separableHor)
+			variants.push_back({ "separable", [=]() { filter_separable_prewitt(inBuffer, outBuffer, width, height, *separableVer, *separableHor, 0, height); } });
+		for (int level = SIMD_SSE41; level <= detectSimdLevel(); ++level)
+			variants.push_back({ string("simd_") + simdLevelName((SimdLevel)level), [=]() {
+				filter_simd_prewitt((SimdLevel)level, inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, height); } });
+	}
 
+	int chosen = selectVariant(prewittCostKey(padded != nullptr), width, height, filterSize, tbb::this_task_arena::max_concurrency(), variants, measured);
+	variants[chosen].run();
+	return variants[chosen].name;
+}
 
 /**
-* @brief Function for running test.
+* @brief Edge detection algorithm with the variant that is fastest on this machine for images of this size,
+* see selectVariant. Variants are serial, task, parallel for, parallel for with affinity and tiled, and for images
+* without padding also running window and summed-area table.
 *
-* @param testNr test identification, 1: for serial version, 2: for parallel version
+* @param inBuffer buffer of input image
+* @param outBuffer buffer of output image
+* @param width image width
+* @param height image height
+* @param lookupWidth size of neighbour lookup matrix
+* @param padded padded copy of input image, when given border pixels are computed too
+* @param measured set to true if variants were timed to choose
+* @return name of the chosen variant
+*/
+template<typename InPixel, typename OutPixel>
+string filter_auto_edge_detection(InPixel* inBuffer, OutPixel* outBuffer, int width, int height, int lookupWidth,
+	const PaddedImage<InPixel>* padded = nullptr, bool* measured = nullptr)
+{
+	vector<Variant> variants(1, Variant{ "serial", [=]() {
+		filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, EDGE_FASTEST, padded); } });
+	vector<Variant> parallel = edge_tbb_variants(inBuffer, outBuffer, width, height, lookupWidth, padded);
+	variants.insert(variants.end(), parallel.begin(), parallel.end());
+
+	if (!padded) {
+		variants.push_back({ "sliding", [=]() { filter_sliding_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, height); } });
+		variants.push_back({ "integral", [=]() {
+			filter_edge_detection_sweep(inBuffer, width, height, vector<int>(1, lookupWidth), vector<OutPixel*>(1, outBuffer)); } });
+	}
+
+	int chosen = selectVariant(edgeCostKey(padded != nullptr), width, height, lookupWidth, tbb::this_task_arena::max_concurrency(), variants, measured);
+	variants[chosen].run();
+	return variants[chosen].name;
+}
+
+
+
+
+/**
+* @brief Prints performance counter metrics of a benchmark, unavailable ones are left out
+*
+* @param stats benchmark statistics with counters
+*/
+void print_counters(const BenchmarkStats& stats)
+{
+	const PerfCounts& counts = stats.counters;
+	double pixels = (double)stats.width * stats.height;
+	const char* separator = " ";
+	cout << "Counters:";
+	if (stats.instructionsPerCycle >= 0) {
+		cout << separator << "IPC " << stats.instructionsPerCycle;
+		separator = ", ";
+	}
+	if (stats.instructionsPerPixel >= 0) {
+		cout << separator << "instructions/pixel " << stats.instructionsPerPixel;
+		separator = ", ";
+	}
+	if (counts.counts[PERF_L1D_MISSES] >= 0) {
+		cout << separator << "L1D misses/pixel " << counts.counts[PERF_L1D_MISSES] / pixels;
+		separator = ", ";
+	}
+	if (stats.llcBytesPerPixel >= 0) {
+		cout << separator << "LLC miss bytes/pixel " << stats.llcBytesPerPixel;
+		separator = ", ";
+	}
+	double branchMisses = perfRatio(counts, PERF_BRANCH_MISSES, PERF_BRANCHES);
+	if (branchMisses >= 0) {
+		cout << separator << "branch misses " << branchMisses * 100 << "%";
+		separator = ", ";
+	}
+	if (counts.counts[PERF_TASK_CLOCK] >= 0 && stats.mean > 0)
+		cout << separator << "busy threads " << counts.counts[PERF_TASK_CLOCK] / 1e9 / stats.mean;
+	cout << endl;
+	if (counts.uncountedThreads > 0)
+		cout << "Counters could not be opened on " << counts.uncountedThreads << " threads, counts are too low" << endl;
+}
+
+/**
+* @brief Function for running test. Kernel is timed by runBenchmark, padding and writing of output are timed separately.
+*
+* @param testNr test identification, 1: for serial version, 2: for parallel version, 15 .. 17: SIMD, static and separable Prewitt,
+* 18, 19: sliding window and bit-packed edge detection
 * @param ioFile input/output file, firstly it's holding buffer from input image and than to hold filtered data
-* @param outFileName output file name
+* @param outFileName output file name, nullptr if output is not written
 * @param outBuffer buffer of output image
 * @param width image width
 * @param height image height
 * @param filterVer vertical component filter
 * @param filterHor horizontal component filter
 * @param filterSize size of the filter
+* @param specialized Prewitt implementation specialized for given filters, nullptr if there is none
+* @param options warm up, repetitions and cache flushing
+* @param border how pixels outside of the image are defined, BORDER_NONE leaves border pixels at 0
+* @param backend threading library of tests 13 and 14
+* @return timing statistics of the kernel
 */
 
 
-void run_test_nr(int testNr, BitmapRawConverter* ioFile, char* outFileName, int* outBuffer, unsigned int width,
-	unsigned int height, int lookupWidth, int* filterVer, int* filterHor, int filterSize )
+BenchmarkStats run_test_nr(int testNr, BitmapRawConverter<Pixel>* ioFile, char* outFileName, Pixel* outBuffer, unsigned int width,
+	unsigned int height, int lookupWidth, const int* filterVer, const int* filterHor, int filterSize, PrewittRows<Pixel, Pixel> specialized,
+	const BenchmarkOptions& options, BorderMode border = BORDER_NONE, ParallelBackend backend = BACKEND_TBB)
 {
+	Pixel* inBuffer = ioFile->getBuffer();
+
 	auto start = tbb::tick_count::now();
+	PaddedImage<Pixel> paddedImage;
+	const PaddedImage<Pixel>* padded = nullptr;
+	if (border != BORDER_NONE) {
+		paddedImage.assign(inBuffer, width, height, std::max(filterSize, lookupWidth) / 2, border);
+		padded = &paddedImage;
+	}
+	double paddingSeconds = (tbb::tick_count::now() - start).seconds();
+
+	TileShape tile;
+	string name, variant;
+	bool measured = false;
+	function<void()> kernel;
 
 	switch (testNr)
 	{
 		case 1:
 			cout << "Running serial version of edge detection using Prewitt operator" << endl;
-			filter_serial_prewitt(ioFile->getBuffer(), outBuffer, width, height, filterVer, filterHor, filterSize);
+			name = "prewitt_serial";
+			kernel = [&]() { filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded); };
 			break;
 		case 2:
 			cout << "Running parallel version of edge detection using Prewitt operator" << endl;
-			filter_parallel_prewitt(ioFile->getBuffer(), outBuffer, width, height, filterVer, filterHor, filterSize);
+			name = "prewitt_task";
+			kernel = [&]() { filter_parallel_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded); };
 			break;
 		case 5:
 			cout << "Running parallel for version of edge detection using Prewitt operator" << endl;
-			filter_parallel_for_prewitt(ioFile->getBuffer(), outBuffer, width, height, filterVer, filterHor, filterSize);
+			name = "prewitt_for";
+			kernel = [&]() { filter_parallel_for_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, false, specialized, padded); };
 			break;
 		case 7:
 			cout << "Running parallel for affinity version of edge detection using Prewitt operator" << endl;
-			filter_parallel_for_prewitt(ioFile->getBuffer(), outBuffer, width, height, filterVer, filterHor, filterSize, true);
+			name = "prewitt_for_affinity";
+			kernel = [&]() { filter_parallel_for_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, true, specialized, padded); };
 			break;
 
 
 		case 3:
 			cout << "Running serial version of edge detection" << endl;
-			filter_serial_edge_detection(ioFile->getBuffer(), outBuffer, width, height, lookupWidth);
+			name = "edge_serial";
+			kernel = [&]() { filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, EDGE_WINDOW_SCAN, padded); };
 			break;
 		case 4:
 			cout << "Running parallel version of edge detection" << endl;
-			filter_parallel_edge_detection(ioFile->getBuffer(), outBuffer, width, height, lookupWidth);
+			name = "edge_task";
+			kernel = [&]() { filter_parallel_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, padded); };
 			break;
 		case 6:
 			cout << "Running parallel for version of edge detection" << endl;
-			filter_parallel_for_edge_detection(ioFile->getBuffer(), outBuffer, width, height, lookupWidth);
+			name = "edge_for";
+			kernel = [&]() { filter_parallel_for_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, false, padded); };
 			break;
 		case 8:
 			cout << "Running parallel for affinity version of edge detection" << endl;
-			filter_parallel_for_edge_detection(ioFile->getBuffer(), outBuffer, width, height, lookupWidth, true);
+			name = "edge_for_affinity";
+			kernel = [&]() { filter_parallel_for_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, true, padded); };
+			break;
+		case 9:
+			tile = chooseTileShape(width, height, filterSize, sizeof(Pixel), sizeof(Pixel));
+			cout << "Running tiled version of edge detection using Prewitt operator, tile " << tile.rows << " x " << tile.columns << endl;
+			name = "prewitt_tiled";
+			kernel = [&]() { filter_tiled_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, tile, padded); };
+			break;
+		case 10:
+			tile = chooseTileShape(width, height, lookupWidth, sizeof(Pixel), sizeof(Pixel));
+			cout << "Running tiled version of edge detection, tile " << tile.rows << " x " << tile.columns << endl;
+			name = "edge_tiled";
+			kernel = [&]() { filter_tiled_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, tile, padded); };
+			break;
+		case 11:
+			cout << "Running auto selected version of edge detection using Prewitt operator" << endl;
+			name = "prewitt_auto";
+			kernel = [&]() {
+				bool profiled = false;
+				variant = filter_auto_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, specialized, padded, &profiled);
+				measured = measured || profiled;
+			};
+			break;
+		case 12:
+			cout << "Running auto selected version of edge detection" << endl;
+			name = "edge_auto";
+			kernel = [&]() {
+				bool profiled = false;
+				variant = filter_auto_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, padded, &profiled);
+				measured = measured || profiled;
+			};
+			break;
+		case 13:
+			cout << "Running " << parallelBackendName(backend) << " version of edge detection using Prewitt operator" << endl;
+			name = string("prewitt_") + parallelBackendName(backend);
+			kernel = [&]() { filter_backend_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, backend, specialized, padded); };
+			break;
+		case 14:
+			cout << "Running " << parallelBackendName(backend) << " version of edge detection" << endl;
+			name = string("edge_") + parallelBackendName(backend);
+			kernel = [&]() { filter_backend_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, backend, padded); };
+			break;
+		case 15:
+			cout << "Running " << simdLevelName(detectSimdLevel()) << " version of edge detection using Prewitt operator" << endl;
+			name = "prewitt_simd";
+			kernel = [&]() { filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded, PREWITT_SIMD); };
+			break;
+		case 16:
+			cout << "Running static version of edge detection using Prewitt operator" << endl;
+			name = "prewitt_static";
+			kernel = [&]() { filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded, PREWITT_STATIC); };
+			break;
+		case 17:
+			cout << "Running separable version of edge detection using Prewitt operator" << endl;
+			name = "prewitt_separable";
+			kernel = [&]() { filter_serial_prewitt(inBuffer, outBuffer, width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded, PREWITT_SEPARABLE); };
+			break;
+		case 18:
+			cout << "Running sliding window version of edge detection" << endl;
+			name = "edge_sliding";
+			kernel = [&]() { filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, EDGE_SLIDING_WINDOW, padded); };
+			break;
+		case 19:
+			cout << "Running bit-packed version of edge detection" << endl;
+			name = "edge_bit_packed";
+			kernel = [&]() { filter_serial_edge_detection(inBuffer, outBuffer, width, height, lookupWidth, 0, -1, EDGE_BIT_PACKED, padded); };
 			break;
 		default:
 			cout << "ERROR: invalid test case, must be 1, 2, 3 or 4!";
-			break;
+			return BenchmarkStats();
 	}
-	auto end = tbb::tick_count::now();
-	cout << "Lasted: " << (end - start).seconds() << endl;
 
+	// auto selected versions profile every candidate in their first run, which must not be timed
+	BenchmarkOptions kernelOptions = options;
+	if (testNr == 11 || testNr == 12)
+		kernelOptions.warmup = std::max(kernelOptions.warmup, 1);
+
+	// input is read and output is written once per run
+	BenchmarkStats stats = runBenchmark(name, width, height, 2.0 * width * height * sizeof(Pixel), kernelOptions, kernel);
+	if (!variant.empty())
+		cout << (measured ? "Profiled and selected " : "Selected ") << variant << endl;
+	if (padded)
+		cout << "Padding lasted: " << paddingSeconds << endl;
+	cout << "Lasted: min " << stats.min << ", median " << stats.median << ", p95 " << stats.p95 << ", stddev " << stats.stddev
+		<< " (" << stats.megapixelsPerSecond << " MP/s, " << stats.gigabytesPerSecond << " GB/s)" << endl;
+	if (perfCountsValid(stats.counters))
+		print_counters(stats);
+
+	if (outFileName == nullptr)
+		return stats;
+	start = tbb::tick_count::now();
 	ioFile->setBuffer(outBuffer);
 	ioFile->pixelsToBitmap(outFileName);
+	cout << "Writing lasted: " << (tbb::tick_count::now() - start).seconds() << endl;
+	return stats;
 }
 
 /**
-* @brief Print program usage.
+* @brief Opens input image, either a bitmap file or a generated image described like "noise:4096x4096", see SyntheticImage
+*
+* @param name bitmap file name or generated image description
+* @return new image, deleted by the caller
 */
-void usage()
+BitmapRawConverter<Pixel>* open_input(char* name)
 {
-	cout << "\n\ERROR: call program like: " << endl << endl; 
-	cout << "ProjekatPP.exe";
-	cout << " input.bmp";
-	cout << " outputSerialPrewitt.bmp";
-	cout << " outputParallelPrewitt.bmp";
-	cout << " outputSerialEdge.bmp";
-	cout << " outputParallelEdge.bmp";
+	SyntheticImage synthetic;
+	if (!parseSyntheticImage(name, synthetic))
+		return new BitmapRawConverter<Pixel>(name);
 
-	cout << " outputParallelForPrewitt.bmp";
-	cout << " outputParallelForEdge.bmp";
-	cout << " outputParallelForAffinityPrewitt.bmp";
-	cout << " outputParallelForAffinityEdge.bmp" << endl << endl;
+	BitmapRawConverter<Pixel>* image = new BitmapRawConverter<Pixel>(synthetic.width, synthetic.height);
+	generateSyntheticImage(image->getBuffer(), synthetic);
+	return image;
 }
 
-int main(int argc, char * argv[])
+/**
+* @brief Measures costs of serial versions used by the cut off of task based versions on a small synthetic image.
+* Costs already stored in calibration file are not measured again, new ones are added to the file.
+*
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param filterSize size of the filter
+* @param lookupWidth size of neighbour lookup matrix
+* @param specialized Prewitt implementation specialized for given filters, nullptr if there is none
+* @param border how pixels outside of the image are defined
+*/
+void calibrate_cut_off(const int* filterVer, const int* filterHor, int filterSize, int lookupWidth, PrewittRows<Pixel, Pixel> specialized,
+	BorderMode border)
 {
-
-	if(argc != __ARG_NUM__)
-	{
-		usage();
-		return 0;
+	loadCutOffCalibration(CALIBRATION_FILE);
+
+	int width = CALIBRATION_WIDTH, height = CALIBRATION_HEIGHT;
+	vector<Pixel> inBuffer(width * height), outBuffer(width * height);
+	SyntheticImage noise = { PATTERN_NOISE, width, height, 0, 1 };
+	generateSyntheticImage(&inBuffer[0], noise);
+
+	PaddedImage<Pixel> paddedImage;
+	const PaddedImage<Pixel>* padded = nullptr;
+	if (border != BORDER_NONE) {
+		paddedImage.assign(&inBuffer[0], width, height, std::max(filterSize, lookupWidth) / 2, border);
+		padded = &paddedImage;
 	}
 
-	BitmapRawConverter inputFile(argv[1]);
-	BitmapRawConverter outputFileSerialPrewitt(argv[1]);
-	BitmapRawConverter outputFileParallelPrewitt(argv[1]);
-	BitmapRawConverter outputFileSerialEdge(argv[1]);
-	BitmapRawConverter outputFileParallelEdge(argv[1]);
-
-	BitmapRawConverter outputFileParallelForPrewitt(argv[1]);
-	BitmapRawConverter outputFileParallelForEdge(argv[1]);
-	BitmapRawConverter outputFileParallelForAffinityPrewitt(argv[1]);
-	BitmapRawConverter outputFileParallelForAffinityEdge(argv[1]);
-
-	unsigned int width, height;
-
-	int test;
-	
-	width = inputFile.getWidth();
-	height = inputFile.getHeight();
-
-	int* outBufferSerialPrewitt = new int[width * height];
-	int* outBufferParallelPrewitt = new int[width * height];
-
-	memset(outBufferSerialPrewitt, 0x0, width * height * sizeof(int));
-	memset(outBufferParallelPrewitt, 0x0, width * height * sizeof(int));
-
-	int* outBufferSerialEdge = new int[width * height];
-	int* outBufferParallelEdge = new int[width * height];
-
-	memset(outBufferSerialEdge, 0x0, width * height * sizeof(int));
-	memset(outBufferParallelEdge, 0x0, width * height * sizeof(int));
-
-
-
-	int* outBufferParallelForPrewitt = new int[width * height];
-	int* outBufferParallelForEdge = new int[width * height];
+	calibratePixelCost(prewittCostKey(padded != nullptr), filterSize, [&]() {
+		filter_serial_prewitt(&inBuffer[0], &outBuffer[0], width, height, filterVer, filterHor, filterSize, 0, -1, specialized, padded, PREWITT_FASTEST);
+	}, (long)width * height);
+	calibratePixelCost(edgeCostKey(padded != nullptr), lookupWidth, [&]() {
+		filter_serial_edge_detection(&inBuffer[0], &outBuffer[0], width, height, lookupWidth, 0, -1, EDGE_FASTEST, padded);
+	}, (long)width * height);
+	taskCost();
 
-	memset(outBufferParallelForPrewitt, 0x0, width * height * sizeof(int));
-	memset(outBufferParallelForEdge, 0x0, width * height * sizeof(int));
-
-	int* outBufferParallelForAffinityPrewitt = new int[width * height];
-	int* outBufferParallelForAffinityEdge = new int[width * height];
-
-	memset(outBufferParallelForAffinityPrewitt, 0x0, width * height * sizeof(int));
-	memset(outBufferParallelForAffinityEdge, 0x0, width * height * sizeof(int));
-
-
-	int lookupWidth;
-	int* filterVer;
-	int* filterHor;
+	if (!saveCutOffCalibration(CALIBRATION_FILE))
+		cout << "Calibration could not be saved to " << CALIBRATION_FILE << endl;
+}
 
+/**
+* @brief Reads filter settings from standard input, invalid values are replaced by defaults
+*
+* @param lookupWidth size of neighbour lookup matrix
+* @param filterSize size of the filter
+* @param filterVer vertical component filter
+* @param filterHor horizontal component filter
+* @param specialized Prewitt implementation specialized for chosen filters
+* @param border how pixels outside of the image are defined
+* @param backend threading library of backend versions
+* @param options warm up, repetitions and cache flushing of benchmarks
+*/
+void read_settings(int& lookupWidth, int& filterSize, const int*& filterVer, const int*& filterHor, PrewittRows<Pixel, Pixel>& specialized,
+	BorderMode& border, ParallelBackend& backend, BenchmarkOptions& options)
+{
 	cout << "Choose lookup width for edge detection: " << endl;
 	cin >> lookupWidth;
 	if (lookupWidth < 3 || lookupWidth % 2 == 0) {
@@ -468,7 +1132,6 @@ int main(int argc, char * argv[])
 		lookupWidth = 3;
 	}
 
-	int filterSize;
 	cout << "Choose filter size for prewitt matrix (valid options are 3, 5 and 7): " << endl;
 	cin >> filterSize;
 	switch (filterSize) {
@@ -476,22 +1139,26 @@ int main(int argc, char * argv[])
 		filterSize = 3;
 		filterHor = filterHor3;
 		filterVer = filterVer3;
+		specialized = filter_static_prewitt<3, filterVer3, filterHor3>;
 		break;
 	case 5:
 		filterSize = 5;
 		filterHor = filterHor5;
 		filterVer = filterVer5;
+		specialized = filter_static_prewitt<5, filterVer5, filterHor5>;
 		break;
 	case 7:
 		filterSize = 7;
 		filterHor = filterHor7;
 		filterVer = filterVer7;
+		specialized = filter_static_prewitt<7, filterVer7, filterHor7>;
 		break;
 	default:
 		cout << "Invalid filter size is selected, default 3 is set" << endl;
 		filterSize = 3;
 		filterHor = filterHor3;
 		filterVer = filterVer3;
+		specialized = filter_static_prewitt<3, filterVer3, filterHor3>;
 	}
 
 	if (filterSize < 3 || filterSize % 2 == 0) {
@@ -499,40 +1166,554 @@ int main(int argc, char * argv[])
 		filterSize = 3;
 		filterHor = filterHor3;
 		filterVer = filterVer3;
+		specialized = filter_static_prewitt<3, filterVer3, filterHor3>;
+	}
+
+	int borderChoice = BORDER_NONE;
+	cout << "Choose border mode (0 none, 1 zero, 2 clamp, 3 reflect): " << endl;
+	if (!(cin >> borderChoice) || borderChoice < BORDER_NONE || borderChoice > BORDER_REFLECT) {
+		cout << "Invalid border mode, default none is set" << endl;
+		borderChoice = BORDER_NONE;
+	}
+	border = (BorderMode)borderChoice;
+
+	int backendChoice = BACKEND_TBB;
+	cout << "Choose parallel backend (0 tbb, 1 openmp, 2 thread pool, 3 serial): " << endl;
+	if (!(cin >> backendChoice) || backendChoice < BACKEND_TBB || backendChoice > BACKEND_SERIAL) {
+		cout << "Invalid parallel backend, default tbb is set" << endl;
+		backendChoice = BACKEND_TBB;
+	}
+	backend = (ParallelBackend)backendChoice;
+	if (!parallelBackendAvailable(backend)) {
+		cout << "Parallel backend " << parallelBackendName(backend) << " is not compiled in, default tbb is set" << endl;
+		backend = BACKEND_TBB;
+	}
+
+	int flushChoice = 0, counterChoice = 0;
+	cout << "Choose benchmark warm up runs, repetitions, cache flush (0 warm, 1 cold) and performance counters (0 off, 1 on): " << endl;
+	if (!(cin >> options.warmup >> options.repetitions >> flushChoice >> counterChoice) || options.warmup < 0 || options.repetitions < 1
+		|| flushChoice < 0 || flushChoice > 1 || counterChoice < 0 || counterChoice > 1) {
+		cout << "Invalid benchmark options, default " << BENCHMARK_WARMUP << " " << BENCHMARK_REPETITIONS << " 0 0 is set" << endl;
+		options.warmup = BENCHMARK_WARMUP;
+		options.repetitions = BENCHMARK_REPETITIONS;
+		flushChoice = 0;
+		counterChoice = 0;
+	}
+	options.flushCache = flushChoice == 1;
+	options.countEvents = counterChoice == 1;
+
+	PerfCounters counters;
+	if (options.countEvents && !counters.start()) {
+		cout << "Performance counters are not available, counting is off" << endl;
+		options.countEvents = false;
+	}
+	else if (options.countEvents)
+		counters.stop();
+}
+
+/**
+* @brief Scaling study mode, times TBB based versions of both filters with 1 .. maxThreads threads on every input image
+* and writes the results. Called like: ProjekatPP.exe --scaling results.csv|results.json maxThreads input.bmp [input2.bmp ...],
+* maxThreads 0 means all threads.
+*
+* @param argc number of program arguments
+* @param argv program arguments
+* @return program exit code
+*/
+int run_scaling_study(int argc, char* argv[])
+{
+	int lookupWidth, filterSize;
+	const int* filterVer;
+	const int* filterHor;
+	PrewittRows<Pixel, Pixel> specialized;
+	BorderMode border;
+	ParallelBackend backend;
+	BenchmarkOptions options;
+	read_settings(lookupWidth, filterSize, filterVer, filterHor, specialized, border, backend, options);
+
+	int allThreads = tbb::this_task_arena::max_concurrency();
+	int maxThreads = atoi(argv[3]);
+	if (maxThreads > allThreads)
+		cout << "Thread count is limited to " << allThreads << endl;
+	if (maxThreads <= 0 || maxThreads > allThreads)
+		maxThreads = allThreads;
+	calibrate_cut_off(filterVer, filterHor, filterSize, lookupWidth, specialized, border);
+
+	vector<ScalingResult> results;
+	for (int k = 4; k < argc; ++k) {
+		BitmapRawConverter<Pixel>* inputFile = open_input(argv[k]);
+		int width = inputFile->getWidth(), height = inputFile->getHeight();
+		vector<Pixel> outBuffer(width * height);
+
+		PaddedImage<Pixel> paddedImage;
+		const PaddedImage<Pixel>* padded = nullptr;
+		if (border != BORDER_NONE) {
+			paddedImage.assign(inputFile->getBuffer(), width, height, std::max(filterSize, lookupWidth) / 2, border);
+			padded = &paddedImage;
+		}
+
+		cout << "Scaling study of " << argv[k] << " (" << width << " x " << height << ")" << endl;
+		vector<ScalingResult> prewitt = runScalingStudy("prewitt", width, height, prewitt_tbb_variants(inputFile->getBuffer(), &outBuffer[0],
+			width, height, filterVer, filterHor, filterSize, specialized, padded), maxThreads, options);
+		vector<ScalingResult> edge = runScalingStudy("edge", width, height, edge_tbb_variants(inputFile->getBuffer(), &outBuffer[0],
+			width, height, lookupWidth, padded), maxThreads, options);
+		results.insert(results.end(), prewitt.begin(), prewitt.end());
+		results.insert(results.end(), edge.begin(), edge.end());
+		delete inputFile;
+	}
+
+	for (size_t k = 0; k < results.size(); ++k)
+		cout << results[k].filter << " " << results[k].variant << " " << results[k].width << "x" << results[k].height << " threads "
+			<< results[k].threads << ": " << results[k].seconds << " s, speedup " << results[k].speedup << ", efficiency "
+			<< results[k].efficiency << ", serial fraction " << results[k].serialFraction << endl;
+
+	if (!saveScalingResults(argv[2], results)) {
+		cout << "Scaling results could not be saved to " << argv[2] << endl;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Stage benchmark mode, times every stage of the program on its own for generated noise images: EasyBMP
+* WriteToFile and ReadFromFile, reading straight to grayscale and grayscale conversion bitmapToPixels for 8, 24 and
+* 32 bit bitmaps, pixelsToBitmap to BMP and straight to 24 bit file, scalar prewitt and detectEdges per pixel
+* functions, and serial versions of both filters. Called like:
+* ProjekatPP.exe --stages results.csv|results.json [WIDTHxHEIGHT ...], default sizes are 256x256, 1024x1024 and 4096x4096.
+*
+* @param argc number of program arguments
+* @param argv program arguments
+* @return program exit code
+*/
+int run_stage_benchmark(int argc, char* argv[])
+{
+	int lookupWidth, filterSize;
+	const int* filterVer;
+	const int* filterHor;
+	PrewittRows<Pixel, Pixel> specialized;
+	BorderMode border;
+	ParallelBackend backend;
+	BenchmarkOptions options;
+	read_settings(lookupWidth, filterSize, filterVer, filterHor, specialized, border, backend, options);
+
+	vector<string> sizes;
+	for (int k = 3; k < argc; ++k)
+		sizes.push_back(argv[k]);
+	if (sizes.empty()) {
+		sizes.push_back("256x256");
+		sizes.push_back("1024x1024");
+		sizes.push_back("4096x4096");
+	}
+	const int bitDepths[] = { 8, 24, 32 };
+	char bitmapFile[] = STAGE_BITMAP_FILE;
+
+	vector<BenchmarkStats> results;
+	auto stage = [&](const string& name, int width, int height, double bytes, const function<void()>& kernel) {
+		BenchmarkStats stats = runBenchmark(name, width, height, bytes, options, kernel);
+		cout << name << " " << width << "x" << height << ": median " << stats.median << " s, " << stats.nanosecondsPerPixel << " ns/pixel, "
+			<< stats.gigabytesPerSecond << " GB/s" << endl;
+		results.push_back(stats);
+	};
+
+	for (size_t k = 0; k < sizes.size(); ++k) {
+		SyntheticImage noise;
+		if (!parseSyntheticImage(("noise:" + sizes[k]).c_str(), noise)) {
+			cout << "Invalid size " << sizes[k] << ", must be WIDTHxHEIGHT" << endl;
+			continue;
+		}
+		int width = noise.width, height = noise.height;
+		BitmapRawConverter<Pixel> image(width, height);
+		generateSyntheticImage(image.getBuffer(), noise);
+		double pixels = (double)width * height;
+
+		for (size_t d = 0; d < sizeof(bitDepths) / sizeof(bitDepths[0]); ++d) {
+			int depth = bitDepths[d];
+			BMP source;
+			source.SetBitDepth(depth);
+			if (depth == 8)
+				CreateGrayscaleColorTable(source);
+			image.pixelsToBitmap(source);
+			double fileBytes = pixels * depth / 8;
+
+			stage("bmp_write_" + to_string(depth), width, height, fileBytes, [&]() { source.WriteToFile(bitmapFile); });
+			stage("bmp_read_" + to_string(depth), width, height, fileBytes, [&]() { BMP bitmap; bitmap.ReadFromFile(bitmapFile); });
+			stage("bmp_read_grayscale_" + to_string(depth), width, height, fileBytes + pixels * sizeof(Pixel),
+				[&]() { BitmapRawConverter<Pixel> grayscale(bitmapFile); });
+			BitmapRawConverter<Pixel> converter(bitmapFile);
+			converter.readBitmap(bitmapFile);
+			stage("bitmap_to_pixels_" + to_string(depth), width, height, pixels * (sizeof(RGBApixel) + sizeof(Pixel)),
+				[&]() { converter.bitmapToPixels(); });
+		}
+
+		BMP out;
+		out.SetBitDepth(24);
+		stage("pixels_to_bitmap", width, height, pixels * (sizeof(Pixel) + sizeof(RGBApixel)), [&]() { image.pixelsToBitmap(out); });
+		stage("pixels_to_file_24", width, height, pixels * (sizeof(Pixel) + 3), [&]() { image.pixelsToBitmap(bitmapFile); });
+
+		Pixel* inBuffer = image.getBuffer();
+		vector<Pixel> outBuffer(width * height);
+		stage("prewitt_pixel", width, height, 2 * pixels * sizeof(Pixel), [&]() {
+			int offset = filterSize / 2;
+			for (int i = offset; i < height - offset; ++i)
+				for (int j = offset; j < width - offset; ++j)
+					outBuffer[i * width + j] = prewitt(i, j, inBuffer, &outBuffer[0], width, filterVer, filterHor, filterSize) >= 128 ? 255 : 0;
+		});
+		stage("detect_edges_pixel", width, height, 2 * pixels * sizeof(Pixel), [&]() {
+			int offset = lookupWidth / 2;
+			for (int i = offset; i < height - offset; ++i)
+				for (int j = offset; j < width - offset; ++j)
+					outBuffer[i * width + j] = detectEdges(i - offset, j - offset, inBuffer, &outBuffer[0], width, lookupWidth) ? 255 : 0;
+		});
+		stage("prewitt_serial", width, height, 2 * pixels * sizeof(Pixel), [&]() {
+			filter_serial_prewitt<Pixel, Pixel>(inBuffer, &outBuffer[0], width, height, filterVer, filterHor, filterSize, 0, -1, specialized, nullptr, PREWITT_FASTEST);
+		});
+		stage("edge_serial", width, height, 2 * pixels * sizeof(Pixel), [&]() {
+			filter_serial_edge_detection<Pixel, Pixel>(inBuffer, &outBuffer[0], width, height, lookupWidth, 0, -1, EDGE_FASTEST, nullptr);
+		});
+	}
+	remove(STAGE_BITMAP_FILE);
+
+	if (!saveBenchmarkResults(argv[2], results)) {
+		cout << "Stage results could not be saved to " << argv[2] << endl;
+		return 1;
 	}
+	return 0;
+}
+
+/**
+* @brief Streaming mode, filters input band by band so memory is set by band height rather than image size. Rows of a
+* band together with halo of max(filterSize, lookupWidth) / 2 rows above and below are decoded to grayscale, both
+* filters process the band in parallel and its rows are written to the outputs before the next band is read. Input
+* and outputs are mapped files, their pages are left to the page cache. Output equals whole image versions without
+* border mode. Called like: ProjekatPP.exe --stream input.bmp outputPrewitt.bmp outputEdge.bmp [bandRows],
+* by default a band has about STREAM_BAND_BYTES input bytes. Input must be uncompressed 24 or 32 bit bitmap.
+*
+* @param argc number of program arguments
+* @param argv program arguments
+* @return program exit code
+*/
+int run_stream(int argc, char* argv[])
+{
+	int lookupWidth, filterSize;
+	const int* filterVer;
+	const int* filterHor;
+	PrewittRows<Pixel, Pixel> specialized;
+	BorderMode border;
+	ParallelBackend backend;
+	BenchmarkOptions options;
+	read_settings(lookupWidth, filterSize, filterVer, filterHor, specialized, border, backend, options);
+	if (border != BORDER_NONE)
+		cout << "Border mode is not supported by streaming, none is used" << endl;
+	if (backend != BACKEND_TBB)
+		cout << "Streaming runs on tbb backend" << endl;
+
+	MappedBitmapReader input;
+	if (!input.open(argv[2])) {
+		cout << "Input " << argv[2] << " can not be streamed, it must be an uncompressed 24 or 32 bit bitmap" << endl;
+		return 1;
+	}
+	int width = input.getWidth(), height = input.getHeight();
+	int bytesPerPixel = input.getBitDepth() / 8;
+	MappedBitmapWriter outputPrewitt, outputEdge;
+	if (!outputPrewitt.create(argv[3], width, height, 24) || !outputEdge.create(argv[4], width, height, 24)) {
+		cout << "Outputs " << argv[3] << " and " << argv[4] << " can not be created" << endl;
+		return 1;
+	}
+
+	int bandRows = argc > 5 ? atoi(argv[5]) : (int)std::min((long)height, std::max(1L, (long)STREAM_BAND_BYTES / ((long)width * bytesPerPixel)));
+	if (bandRows <= 0) {
+		cout << "Invalid band height, whole image is one band" << endl;
+		bandRows = height;
+	}
+	int halo = std::max(filterSize, lookupWidth) / 2;
+	calibrate_cut_off(filterVer, filterHor, filterSize, lookupWidth, specialized, BORDER_NONE);
+	cout << "Streaming " << argv[2] << " (" << width << " x " << height << ") in bands of " << bandRows << " rows, halo " << halo << " rows"
+		<< endl;
+
+	// input rows of a band with halo, filter outputs of its rows
+	size_t bufferRows = (size_t)std::min(height, bandRows + 2 * halo);
+	vector<Pixel> inBuffer(bufferRows * width), outBufferPrewitt(bufferRows * width), outBufferEdge(bufferRows * width);
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int bandStart = 0; bandStart < height; bandStart += bandRows) {
+		int bandEnd = std::min(height, bandStart + bandRows);
+		int bufferStart = std::max(0, bandStart - halo), bufferEnd = std::min(height, bandEnd + halo);
+		int rows = bufferEnd - bufferStart;
+
+		tbb::parallel_for(tbb::blocked_range<int>(bufferStart, bufferEnd), [&](const tbb::blocked_range<int>& range) {
+			TRACE_SCOPE("decode band", TRACE_DECODE, range.begin(), range.end());
+			for (int i = range.begin(); i < range.end(); ++i)
+				decodeLuminanceRow(input.getRow(i), bytesPerPixel, &inBuffer[(size_t)(i - bufferStart) * width], width);
+		});
+
+		// rows outside of the filtered ones stay 0 like in the whole image versions
+		fill(outBufferPrewitt.begin(), outBufferPrewitt.end(), 0);
+		fill(outBufferEdge.begin(), outBufferEdge.end(), 0);
+		filter_parallel_prewitt(&inBuffer[0], &outBufferPrewitt[0], width, rows, filterVer, filterHor, filterSize,
+			bandStart - bufferStart, bandEnd - bufferStart, specialized);
+		filter_parallel_edge_detection(&inBuffer[0], &outBufferEdge[0], width, rows, lookupWidth, bandStart - bufferStart, bandEnd - bufferStart);
+
+		tbb::parallel_for(tbb::blocked_range<int>(bandStart, bandEnd), [&](const tbb::blocked_range<int>& range) {
+			TRACE_SCOPE("encode band", TRACE_ENCODE, range.begin(), range.end());
+			for (int i = range.begin(); i < range.end(); ++i) {
+				encodeGrayscaleRow(&outBufferPrewitt[(size_t)(i - bufferStart) * width], outputPrewitt.getRow(i), 3, width);
+				encodeGrayscaleRow(&outBufferEdge[(size_t)(i - bufferStart) * width], outputEdge.getRow(i), 3, width);
+			}
+		});
+	}
+	outputPrewitt.close();
+	outputEdge.close();
+	cout << "Streaming time: " << (tbb::tick_count::now() - start).seconds() << " s, band buffers "
+		<< 3 * bufferRows * width * sizeof(Pixel) / 1024 << " KB" << endl;
+	return 0;
+}
+
+/**
+* @brief Print program usage.
+*/
+void usage()
+{
+	cout << "\n\ERROR: call program like: " << endl << endl; 
+	cout << "ProjekatPP.exe";
+	cout << " input.bmp";
+	cout << " outputSerialPrewitt.bmp";
+	cout << " outputParallelPrewitt.bmp";
+	cout << " outputSerialEdge.bmp";
+	cout << " outputParallelEdge.bmp";
+
+	cout << " outputParallelForPrewitt.bmp";
+	cout << " outputParallelForEdge.bmp";
+	cout << " outputParallelForAffinityPrewitt.bmp";
+	cout << " outputParallelForAffinityEdge.bmp";
+	cout << " [outputFusedPrewitt.bmp [outputPackedEdge.bmp]]" << endl;
+	cout << "or: ProjekatPP.exe " << SCALING_OPTION << " results.csv|results.json maxThreads input.bmp [input2.bmp ...]" << endl;
+	cout << "or: ProjekatPP.exe " << STAGES_OPTION << " results.csv|results.json [WIDTHxHEIGHT ...]" << endl;
+	cout << "or: ProjekatPP.exe " << STREAM_OPTION << " input.bmp outputPrewitt.bmp outputEdge.bmp [bandRows]" << endl;
+	cout << "input.bmp can be replaced by generated image pattern:WIDTHxHEIGHT[:scale], patterns are gradient, checkerboard, noise,"
+		<< " sparse_edges and dense_edges" << endl << endl;
+}
+
+int main(int argc, char * argv[])
+{
+
+	if (argc >= 5 && strcmp(argv[1], SCALING_OPTION) == 0)
+		return run_scaling_study(argc, argv);
+	if (argc >= 3 && strcmp(argv[1], STAGES_OPTION) == 0)
+		return run_stage_benchmark(argc, argv);
+	if (argc >= 5 && strcmp(argv[1], STREAM_OPTION) == 0)
+		return run_stream(argc, argv);
+
+	if(argc < __ARG_NUM__ || argc > __ARG_NUM__ + 2)
+	{
+		usage();
+		return 0;
+	}
+
+	BitmapRawConverter<Pixel>* inputFile = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileSerialPrewitt = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileParallelPrewitt = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileSerialEdge = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileParallelEdge = open_input(argv[1]);
+
+	BitmapRawConverter<Pixel>* outputFileParallelForPrewitt = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileParallelForEdge = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileParallelForAffinityPrewitt = open_input(argv[1]);
+	BitmapRawConverter<Pixel>* outputFileParallelForAffinityEdge = open_input(argv[1]);
+
+	unsigned int width, height;
+
+	int test;
+	
+	width = inputFile->getWidth();
+	height = inputFile->getHeight();
+
+	Pixel* outBufferSerialPrewitt = new Pixel[width * height];
+	Pixel* outBufferParallelPrewitt = new Pixel[width * height];
+
+	memset(outBufferSerialPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferParallelPrewitt, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferSerialEdge = new Pixel[width * height];
+	Pixel* outBufferParallelEdge = new Pixel[width * height];
+
+	memset(outBufferSerialEdge, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferParallelEdge, 0x0, width * height * sizeof(Pixel));
+
+
+
+	Pixel* outBufferParallelForPrewitt = new Pixel[width * height];
+	Pixel* outBufferParallelForEdge = new Pixel[width * height];
+
+	memset(outBufferParallelForPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferParallelForEdge, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferParallelForAffinityPrewitt = new Pixel[width * height];
+	Pixel* outBufferParallelForAffinityEdge = new Pixel[width * height];
+
+	memset(outBufferParallelForAffinityPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferParallelForAffinityEdge, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferTiledPrewitt = new Pixel[width * height];
+	Pixel* outBufferTiledEdge = new Pixel[width * height];
+
+	memset(outBufferTiledPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferTiledEdge, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferAutoPrewitt = new Pixel[width * height];
+	Pixel* outBufferAutoEdge = new Pixel[width * height];
+
+	memset(outBufferAutoPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferAutoEdge, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferBackendPrewitt = new Pixel[width * height];
+	Pixel* outBufferBackendEdge = new Pixel[width * height];
+
+	memset(outBufferBackendPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferBackendEdge, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferSimdPrewitt = new Pixel[width * height];
+	Pixel* outBufferStaticPrewitt = new Pixel[width * height];
+	Pixel* outBufferSeparablePrewitt = new Pixel[width * height];
+
+	memset(outBufferSimdPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferStaticPrewitt, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferSeparablePrewitt, 0x0, width * height * sizeof(Pixel));
+
+	Pixel* outBufferSlidingEdge = new Pixel[width * height];
+	Pixel* outBufferBitPackedEdge = new Pixel[width * height];
+
+	memset(outBufferSlidingEdge, 0x0, width * height * sizeof(Pixel));
+	memset(outBufferBitPackedEdge, 0x0, width * height * sizeof(Pixel));
+
+
+	int lookupWidth, filterSize;
+	const int* filterVer;
+	const int* filterHor;
+	PrewittRows<Pixel, Pixel> specialized;
+	BorderMode border;
+	ParallelBackend backend;
+	BenchmarkOptions options;
+	read_settings(lookupWidth, filterSize, filterVer, filterHor, specialized, border, backend, options);
+
+	cout << "Prewitt operator instruction set: " << simdLevelName(detectSimdLevel()) << endl;
+	cout << "Border mode: " << borderModeName(border) << endl;
+	cout << "Parallel backend: " << parallelBackendName(backend) << " (" << parallelBackendThreads(backend) << " threads)" << endl;
+	cout << "Data cache: L1 " << dataCacheSize(1) / 1024 << " KB, L2 " << dataCacheSize(2) / 1024 << " KB" << endl;
+
+	calibrate_cut_off(filterVer, filterHor, filterSize, lookupWidth, specialized, border);
+	loadVariantProfile(PROFILE_FILE);
+	int threads = tbb::this_task_arena::max_concurrency();
+	cout << "Task cut off (" << threads << " threads): Prewitt "
+		<< leafPixels(pixelCost(prewittCostKey(border != BORDER_NONE), filterSize), (long)width * height, threads) << " pixels, edge detection "
+		<< leafPixels(pixelCost(edgeCostKey(border != BORDER_NONE), lookupWidth), (long)width * height, threads) << " pixels" << endl;
+	cout << "Benchmark: " << options.warmup << " warm up, " << options.repetitions << " timed runs, " << (options.flushCache ? "cold" : "warm")
+		<< " cache" << endl;
+	vector<BenchmarkStats> results;
 
 	// serial version Prewitt
-	run_test_nr(1, &outputFileSerialPrewitt, argv[2], outBufferSerialPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(1, outputFileSerialPrewitt, argv[2], outBufferSerialPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel version Prewitt
-	run_test_nr(2, &outputFileParallelPrewitt, argv[3], outBufferParallelPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(2, outputFileParallelPrewitt, argv[3], outBufferParallelPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel for version Prewitt
-	run_test_nr(5, &outputFileParallelForPrewitt, argv[6], outBufferParallelForPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(5, outputFileParallelForPrewitt, argv[6], outBufferParallelForPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel for version Prewitt
-	run_test_nr(7, &outputFileParallelForAffinityPrewitt, argv[8], outBufferParallelForAffinityPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(7, outputFileParallelForAffinityPrewitt, argv[8], outBufferParallelForAffinityPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// tiled version Prewitt, output is only verified
+	results.push_back(run_test_nr(9, inputFile, nullptr, outBufferTiledPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// auto selected version Prewitt, output is only verified
+	results.push_back(run_test_nr(11, inputFile, nullptr, outBufferAutoPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// chosen parallel backend version Prewitt, output is only verified
+	results.push_back(run_test_nr(13, inputFile, nullptr, outBufferBackendPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border, backend));
+
+	// SIMD, static and separable Prewitt, only for image without padding, output is only verified
+	bool simd = border == BORDER_NONE && detectSimdLevel() != SIMD_SCALAR;
+	bool separable = border == BORDER_NONE && findKernelDecomposition(filterVer, filterSize) && findKernelDecomposition(filterHor, filterSize);
+	if (simd)
+		results.push_back(run_test_nr(15, inputFile, nullptr, outBufferSimdPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+	if (border == BORDER_NONE)
+		results.push_back(run_test_nr(16, inputFile, nullptr, outBufferStaticPrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+	if (separable)
+		results.push_back(run_test_nr(17, inputFile, nullptr, outBufferSeparablePrewitt, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	cout << endl << endl;
 
 	// serial version special
-	run_test_nr(3, &outputFileSerialEdge, argv[4], outBufferSerialEdge, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(3, outputFileSerialEdge, argv[4], outBufferSerialEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel version special
-	run_test_nr(4, &outputFileParallelEdge, argv[5], outBufferParallelEdge, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(4, outputFileParallelEdge, argv[5], outBufferParallelEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel for version special
-	run_test_nr(6, &outputFileParallelForEdge, argv[7], outBufferParallelForEdge, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(6, outputFileParallelForEdge, argv[7], outBufferParallelForEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
 
 	// parallel for version special
-	run_test_nr(8, &outputFileParallelForAffinityEdge, argv[9], outBufferParallelForAffinityEdge, width, height, lookupWidth, filterVer, filterHor, filterSize);
+	results.push_back(run_test_nr(8, outputFileParallelForAffinityEdge, argv[9], outBufferParallelForAffinityEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// tiled version special, output is only verified
+	results.push_back(run_test_nr(10, inputFile, nullptr, outBufferTiledEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// auto selected version special, output is only verified
+	results.push_back(run_test_nr(12, inputFile, nullptr, outBufferAutoEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+
+	// chosen parallel backend version special, output is only verified
+	results.push_back(run_test_nr(14, inputFile, nullptr, outBufferBackendEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border, backend));
+
+	// sliding window and bit-packed edge detection, only for image without padding, output is only verified
+	if (border == BORDER_NONE) {
+		results.push_back(run_test_nr(18, inputFile, nullptr, outBufferSlidingEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+		results.push_back(run_test_nr(19, inputFile, nullptr, outBufferBitPackedEdge, width, height, lookupWidth, filterVer, filterHor, filterSize, specialized, options, border));
+	}
+
+	if (!saveVariantProfile(PROFILE_FILE))
+		cout << "Variant profile could not be saved to " << PROFILE_FILE << endl;
+	if (!saveBenchmarkResults(BENCHMARK_FILE, results))
+		cout << "Benchmark results could not be saved to " << BENCHMARK_FILE << endl;
+#ifdef ENABLE_TRACING
+	if (!saveTrace(TRACE_FILE))
+		cout << "Trace could not be saved to " << TRACE_FILE << endl;
+#endif
+
+	// fused version Prewitt, straight from input to output file
+	bool fused = false;
+	if (argc >= __ARG_NUM__ + 1) {
+		cout << "Running fused version of edge detection using Prewitt operator" << endl;
+		auto start = tbb::tick_count::now();
+		fused = filter_fused_prewitt(argv[1], argv[10], filterVer, filterHor, filterSize);
+		auto end = tbb::tick_count::now();
+		if (fused)
+			cout << "Lasted: " << (end - start).seconds() << endl;
+		else
+			cout << "Fused version supports only uncompressed 24 and 32 bit bitmap files" << endl;
+	}
+
+	// bit-packed version edge detection, edges are written as 1 bit per pixel bitmap without unpacking
+	bool packed = false;
+	if (argc == __ARG_NUM__ + 2) {
+		cout << "Running bit-packed version of edge detection with 1 bit per pixel output" << endl;
+		auto start = tbb::tick_count::now();
+		PackedImage packedEdges;
+		packedEdges.resize(width, height);
+		filter_binary_edge_detection(inputFile->getBuffer(), packedEdges, width, height, lookupWidth, 0, height);
+		packed = writePackedBitmap(argv[11], packedEdges);
+		auto end = tbb::tick_count::now();
+		if (packed)
+			cout << "Lasted: " << (end - start).seconds() << endl;
+		else
+			cout << "Packed edges could not be written to " << argv[11] << endl;
+	}
 
 	cout << endl << endl;
 
 	// verification
 	cout << "Verification: " << endl;
 	// task parallel
-	test = memcmp(outBufferSerialPrewitt, outBufferParallelPrewitt, width * height * sizeof(int));
+	test = memcmp(outBufferSerialPrewitt, outBufferParallelPrewitt, width * height * sizeof(Pixel));
 
 	if(test != 0)
 	{
@@ -544,7 +1725,7 @@ int main(int argc, char * argv[])
 	}
 
 	// parallel for
-	test = memcmp(outBufferSerialPrewitt, outBufferParallelForPrewitt, width * height * sizeof(int));
+	test = memcmp(outBufferSerialPrewitt, outBufferParallelForPrewitt, width * height * sizeof(Pixel));
 
 	if (test != 0)
 	{
@@ -556,7 +1737,7 @@ int main(int argc, char * argv[])
 	}
 
 	// parallel for affinity
-	test = memcmp(outBufferSerialPrewitt, outBufferParallelForAffinityPrewitt, width * height * sizeof(int));
+	test = memcmp(outBufferSerialPrewitt, outBufferParallelForAffinityPrewitt, width * height * sizeof(Pixel));
 
 	if (test != 0)
 	{
@@ -567,11 +1748,104 @@ int main(int argc, char * argv[])
 		cout << "Prewitt for affinity PASS." << endl;
 	}
 
+	// tiled
+	test = memcmp(outBufferSerialPrewitt, outBufferTiledPrewitt, width * height * sizeof(Pixel));
+
+	if (test != 0)
+	{
+		cout << "Prewitt tiled FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Prewitt tiled PASS." << endl;
+	}
+
+	// auto selected
+	test = memcmp(outBufferSerialPrewitt, outBufferAutoPrewitt, width * height * sizeof(Pixel));
+
+	if (test != 0)
+	{
+		cout << "Prewitt auto FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Prewitt auto PASS." << endl;
+	}
+
+	// chosen parallel backend
+	test = memcmp(outBufferSerialPrewitt, outBufferBackendPrewitt, width * height * sizeof(Pixel));
+
+	if (test != 0)
+	{
+		cout << "Prewitt " << parallelBackendName(backend) << " FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Prewitt " << parallelBackendName(backend) << " PASS." << endl;
+	}
+
+	// SIMD
+	if (simd) {
+		test = memcmp(outBufferSerialPrewitt, outBufferSimdPrewitt, width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Prewitt " << simdLevelName(detectSimdLevel()) << " FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Prewitt " << simdLevelName(detectSimdLevel()) << " PASS." << endl;
+		}
+	}
+
+	// static
+	if (border == BORDER_NONE) {
+		test = memcmp(outBufferSerialPrewitt, outBufferStaticPrewitt, width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Prewitt static FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Prewitt static PASS." << endl;
+		}
+	}
+
+	// separable
+	if (separable) {
+		test = memcmp(outBufferSerialPrewitt, outBufferSeparablePrewitt, width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Prewitt separable FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Prewitt separable PASS." << endl;
+		}
+	}
+
+	// fused, border pixels are always 0
+	if (fused && border == BORDER_NONE) {
+		BitmapRawConverter<Pixel> outputFileFusedPrewitt(argv[10]);
+		test = memcmp(outBufferSerialPrewitt, outputFileFusedPrewitt.getBuffer(), width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Prewitt fused FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Prewitt fused PASS." << endl;
+		}
+	}
+
 
 
 
 	// task parallel 
-	test = memcmp(outBufferSerialEdge, outBufferParallelEdge, width * height * sizeof(int));
+	test = memcmp(outBufferSerialEdge, outBufferParallelEdge, width * height * sizeof(Pixel));
 
 	if(test != 0)
 	{
@@ -583,7 +1857,7 @@ int main(int argc, char * argv[])
 	}
 
 	// parallel for
-	test = memcmp(outBufferSerialEdge, outBufferParallelForEdge, width * height * sizeof(int));
+	test = memcmp(outBufferSerialEdge, outBufferParallelForEdge, width * height * sizeof(Pixel));
 
 	if (test != 0)
 	{
@@ -595,7 +1869,7 @@ int main(int argc, char * argv[])
 	}
 
 	// parallel for
-	test = memcmp(outBufferSerialEdge, outBufferParallelForAffinityEdge, width * height * sizeof(int));
+	test = memcmp(outBufferSerialEdge, outBufferParallelForAffinityEdge, width * height * sizeof(Pixel));
 
 	if (test != 0)
 	{
@@ -606,17 +1880,141 @@ int main(int argc, char * argv[])
 		cout << "Edge detection for affinity PASS." << endl;
 	}
 
-	// clean up
-	delete outBufferSerialPrewitt;
-	delete outBufferParallelPrewitt;
+	// tiled
+	test = memcmp(outBufferSerialEdge, outBufferTiledEdge, width * height * sizeof(Pixel));
+
+	if (test != 0)
+	{
+		cout << "Edge detection tiled FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Edge detection tiled PASS." << endl;
+	}
 
-	delete outBufferSerialEdge;
-	delete outBufferParallelEdge;
+	// auto selected
+	test = memcmp(outBufferSerialEdge, outBufferAutoEdge, width * height * sizeof(Pixel));
 
-	delete outBufferParallelForPrewitt;
-	delete outBufferParallelForEdge;
-	delete outBufferParallelForAffinityPrewitt;
-	delete outBufferParallelForAffinityEdge;
+	if (test != 0)
+	{
+		cout << "Edge detection auto FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Edge detection auto PASS." << endl;
+	}
+
+	// chosen parallel backend
+	test = memcmp(outBufferSerialEdge, outBufferBackendEdge, width * height * sizeof(Pixel));
+
+	if (test != 0)
+	{
+		cout << "Edge detection " << parallelBackendName(backend) << " FAIL!" << endl;
+	}
+	else
+	{
+		cout << "Edge detection " << parallelBackendName(backend) << " PASS." << endl;
+	}
+
+	// sliding window and bit-packed
+	if (border == BORDER_NONE) {
+		test = memcmp(outBufferSerialEdge, outBufferSlidingEdge, width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Edge detection sliding FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Edge detection sliding PASS." << endl;
+		}
+
+		test = memcmp(outBufferSerialEdge, outBufferBitPackedEdge, width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Edge detection bit-packed FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Edge detection bit-packed PASS." << endl;
+		}
+	}
+
+	// summed-area table sweep over several lookup widths in one call, every map against serial version of its width
+	vector<int> sweepWidths = SWEEP_LOOKUP_WIDTHS;
+	vector<vector<Pixel> > sweepBuffers(sweepWidths.size(), vector<Pixel>(width * height));
+	vector<Pixel*> sweepOutputs;
+	for (size_t k = 0; k < sweepWidths.size(); ++k)
+		sweepOutputs.push_back(&sweepBuffers[k][0]);
+	filter_edge_detection_sweep(inputFile->getBuffer(), width, height, sweepWidths, sweepOutputs);
+	for (size_t k = 0; k < sweepWidths.size(); ++k) {
+		vector<Pixel> serialBuffer(width * height);
+		filter_serial_edge_detection(inputFile->getBuffer(), &serialBuffer[0], width, height, sweepWidths[k]);
+		test = memcmp(&serialBuffer[0], sweepOutputs[k], width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Edge detection sweep " << sweepWidths[k] << " FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Edge detection sweep " << sweepWidths[k] << " PASS." << endl;
+		}
+	}
+
+	// bit-packed 1 bit per pixel file, border pixels are always 0
+	if (packed && border == BORDER_NONE) {
+		BitmapRawConverter<Pixel> outputFilePackedEdge(argv[11]);
+		test = memcmp(outBufferSerialEdge, outputFilePackedEdge.getBuffer(), width * height * sizeof(Pixel));
+
+		if (test != 0)
+		{
+			cout << "Edge detection packed FAIL!" << endl;
+		}
+		else
+		{
+			cout << "Edge detection packed PASS." << endl;
+		}
+	}
+
+	// clean up
+	delete inputFile;
+	delete outputFileSerialPrewitt;
+	delete outputFileParallelPrewitt;
+	delete outputFileSerialEdge;
+	delete outputFileParallelEdge;
+	delete outputFileParallelForPrewitt;
+	delete outputFileParallelForEdge;
+	delete outputFileParallelForAffinityPrewitt;
+	delete outputFileParallelForAffinityEdge;
+
+	delete[] outBufferSerialPrewitt;
+	delete[] outBufferParallelPrewitt;
+
+	delete[] outBufferSerialEdge;
+	delete[] outBufferParallelEdge;
+
+	delete[] outBufferParallelForPrewitt;
+	delete[] outBufferParallelForEdge;
+	delete[] outBufferParallelForAffinityPrewitt;
+	delete[] outBufferParallelForAffinityEdge;
+
+	delete[] outBufferTiledPrewitt;
+	delete[] outBufferTiledEdge;
+
+	delete[] outBufferAutoPrewitt;
+	delete[] outBufferAutoEdge;
+
+	delete[] outBufferBackendPrewitt;
+	delete[] outBufferBackendEdge;
+
+	delete[] outBufferSimdPrewitt;
+	delete[] outBufferStaticPrewitt;
+	delete[] outBufferSeparablePrewitt;
+
+	delete[] outBufferSlidingEdge;
+	delete[] outBufferBitPackedEdge;
 
 	return 0;
 } 
\ No newline at end of file